@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <checkqueue.h>
 #include <common/system.h>
+#include <hash.h>
 #include <key.h>
 #include <prevector.h>
 #include <random.h>
@@ -66,3 +67,63 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     });
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob, benchmark::PriorityLevel::HIGH);
+
+// This Benchmark shows how the CheckQueue scales with the number of threads,
+// using checks that do a varying amount of hashing as a stand-in for script
+// checks with different numbers of signature operations. Each transaction's
+// checks are added separately, like ConnectBlock does.
+static void CCheckQueueScaling(benchmark::Bench& bench, int threads)
+{
+    struct HashJob {
+        uint256 hash;
+        uint32_t rounds;
+        explicit HashJob(FastRandomContext& insecure_rand)
+            : hash{insecure_rand.rand256()},
+              // Most inputs have a single signature, some have many.
+              rounds{insecure_rand.randrange(10) == 0 ? 1 + uint32_t(insecure_rand.randrange(100)) : 1} {}
+        std::optional<int> operator()()
+        {
+            for (uint32_t i = 0; i < rounds * 100; ++i) {
+                hash = Hash(hash);
+            }
+            ankerl::nanobench::doNotOptimizeAway(hash);
+            return std::nullopt;
+        }
+    };
+
+    // The master thread joins the workers in Complete().
+    CCheckQueue<HashJob> queue{QUEUE_BATCH_SIZE, threads - 1};
+
+    FastRandomContext insecure_rand(true);
+    std::vector<std::vector<HashJob>> vBatches(BATCHES);
+    for (auto& vChecks : vBatches) {
+        const size_t num_inputs{1 + insecure_rand.randrange(BATCH_SIZE)};
+        vChecks.reserve(num_inputs);
+        for (size_t x = 0; x < num_inputs; ++x)
+            vChecks.emplace_back(insecure_rand);
+    }
+
+    bench.minEpochIterations(10).unit("block").run([&] {
+        CCheckQueueControl<HashJob> control(&queue);
+        for (auto vChecks : vBatches) {
+            control.Add(std::move(vChecks));
+        }
+        control.Complete();
+    });
+}
+
+static void CCheckQueueScaling1Thread(benchmark::Bench& bench) { CCheckQueueScaling(bench, 1); }
+static void CCheckQueueScaling2Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 2); }
+static void CCheckQueueScaling4Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 4); }
+static void CCheckQueueScaling8Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 8); }
+static void CCheckQueueScaling16Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 16); }
+static void CCheckQueueScaling32Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 32); }
+static void CCheckQueueScaling64Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 64); }
+
+BENCHMARK(CCheckQueueScaling1Thread, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling2Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling4Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling8Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling16Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling32Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling64Threads, benchmark::PriorityLevel::LOW);
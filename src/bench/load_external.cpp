@@ -16,19 +16,17 @@
 
 #include <cstdint>
 #include <cstdio>
-#include <map>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 
 /**
- * The LoadExternalBlockFile() function is used during -reindex and -loadblock.
+ * The LoadExternalBlockFile() function is used during -loadblock.
  *
  * Create a test file that's similar to a datadir/blocks/blk?????.dat file,
  * It contains around 134 copies of the same block (typical size of real block files).
  * For each block in the file, LoadExternalBlockFile() won't find its parent,
- * and so will skip the block. (In the real system, it will re-read the block
- * from disk later when it encounters its parent.)
+ * and so will skip the block.
  *
  * This benchmark measures the performance of deserializing the block (or just
  * its header, beginning with PR 16981).
@@ -61,13 +59,11 @@ static void LoadExternalBlockFile(benchmark::Bench& bench)
         fclose(file);
     }
 
-    std::multimap<uint256, FlatFilePos> blocks_with_unknown_parent;
-    FlatFilePos pos;
     bench.run([&] {
         // "rb" is "binary, O_RDONLY", positioned to the start of the file.
         // The file will be closed by LoadExternalBlockFile().
         AutoFile file{fsbridge::fopen(blkfile, "rb")};
-        testing_setup->m_node.chainman->LoadExternalBlockFile(file, &pos, &blocks_with_unknown_parent);
+        testing_setup->m_node.chainman->LoadExternalBlockFile(file);
     });
     fs::remove(blkfile);
 }
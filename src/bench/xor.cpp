@@ -21,4 +21,36 @@ static void Xor(benchmark::Bench& bench)
     });
 }
 
+// Block files and LevelDB values are obfuscated with 8-byte keys.
+static void XorBlockSized(benchmark::Bench& bench)
+{
+    FastRandomContext frc{/*fDeterministic=*/true};
+    auto data{frc.randbytes<std::byte>(1'000'000)};
+    auto key{frc.randbytes<std::byte>(8)};
+
+    bench.batch(data.size()).unit("byte").run([&] {
+        util::Xor(data, key, /*key_offset=*/3);
+    });
+}
+
+static void XorSmallValues(benchmark::Bench& bench)
+{
+    FastRandomContext frc{/*fDeterministic=*/true};
+    std::vector<std::vector<std::byte>> values;
+    size_t total{0};
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(frc.randbytes<std::byte>(frc.randrange(100)));
+        total += values.back().size();
+    }
+    auto key{frc.randbytes<std::byte>(8)};
+
+    bench.batch(total).unit("byte").run([&] {
+        for (auto& value : values) {
+            util::Xor(value, key);
+        }
+    });
+}
+
 BENCHMARK(Xor, benchmark::PriorityLevel::HIGH);
+BENCHMARK(XorBlockSized, benchmark::PriorityLevel::HIGH);
+BENCHMARK(XorSmallValues, benchmark::PriorityLevel::HIGH);
@@ -15,6 +15,7 @@
 #include <txmempool.h>
 #include <validation.h>
 
+#include <bitset>
 #include <unordered_map>
 
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, const uint64_t nonce) :
@@ -104,11 +105,21 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
     if (shorttxids.size() != cmpctblock.shorttxids.size())
         return READ_STATUS_FAILED; // Short ID collision
 
+    // Nearly all mempool transactions are not in the block. Short IDs are uniformly
+    // distributed, so a small bitmap of their low bits rejects most of those without
+    // a map lookup.
+    static constexpr size_t SHORTID_FILTER_BITS{1 << 16};
+    std::bitset<SHORTID_FILTER_BITS> shortid_filter;
+    for (const uint64_t shortid : cmpctblock.shorttxids) {
+        shortid_filter.set(shortid % SHORTID_FILTER_BITS);
+    }
+
     std::vector<bool> have_txn(txn_available.size());
     {
     LOCK(pool->cs);
-    for (const auto& tx : pool->txns_randomized) {
-        uint64_t shortid = cmpctblock.GetShortID(tx->GetWitnessHash());
+    for (const auto& [wtxid, tx] : pool->txns_randomized) {
+        uint64_t shortid = cmpctblock.GetShortID(wtxid);
+        if (!shortid_filter[shortid % SHORTID_FILTER_BITS]) continue;
         std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
         if (idit != shorttxids.end()) {
             if (!have_txn[idit->second]) {
@@ -175,16 +175,23 @@ public:
             return;
         }
 
+        const size_t num_checks{vChecks.size()};
         {
             LOCK(m_mutex);
             queue.insert(queue.end(), std::make_move_iterator(vChecks.begin()), std::make_move_iterator(vChecks.end()));
-            nTodo += vChecks.size();
+            nTodo += num_checks;
         }
 
-        if (vChecks.size() == 1) {
-            m_worker_cv.notify_one();
-        } else {
+        // Only wake as many workers as there are new checks. Waking the whole
+        // pool for a handful of checks (e.g. a transaction with a few inputs)
+        // makes the workers that find nothing left to do contend on m_mutex
+        // with the ones that do, which limits scaling with many threads.
+        if (num_checks >= m_worker_threads.size()) {
             m_worker_cv.notify_all();
+        } else {
+            for (size_t i = 0; i < num_checks; ++i) {
+                m_worker_cv.notify_one();
+            }
         }
     }
 
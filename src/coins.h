@@ -123,24 +123,31 @@ private:
      * CCoinsViewCache. Nevertheless, if a spent coin is retrieved from the
      * parent cache, the FRESH-but-not-DIRTY coin will be tracked by the linked
      * list and deleted when Sync or Flush is called on the CCoinsViewCache.
+     *
+     * The flags are stored in the low bits of the pointer to the previous
+     * entry, which are always zero due to the alignment of CoinsCachePair.
+     * This saves a padded word in every entry of the cache.
      */
-    CoinsCachePair* m_prev{nullptr};
+    uintptr_t m_prev_and_flags{0};
     CoinsCachePair* m_next{nullptr};
-    uint8_t m_flags{0};
+
+    uint8_t GetFlags() const noexcept { return m_prev_and_flags & (DIRTY | FRESH); }
+    CoinsCachePair* GetPrev() const noexcept { return reinterpret_cast<CoinsCachePair*>(m_prev_and_flags & ~uintptr_t{DIRTY | FRESH}); }
+    void SetPrev(CoinsCachePair* prev) noexcept { m_prev_and_flags = reinterpret_cast<uintptr_t>(prev) | GetFlags(); }
 
     //! Adding a flag requires a reference to the sentinel of the flagged pair linked list.
     static void AddFlags(uint8_t flags, CoinsCachePair& pair, CoinsCachePair& sentinel) noexcept
     {
         Assume(flags & (DIRTY | FRESH));
-        if (!pair.second.m_flags) {
-            Assume(!pair.second.m_prev && !pair.second.m_next);
-            pair.second.m_prev = sentinel.second.m_prev;
+        if (!pair.second.GetFlags()) {
+            Assume(!pair.second.GetPrev() && !pair.second.m_next);
+            pair.second.SetPrev(sentinel.second.GetPrev());
             pair.second.m_next = &sentinel;
-            sentinel.second.m_prev = &pair;
-            pair.second.m_prev->second.m_next = &pair;
+            sentinel.second.SetPrev(&pair);
+            pair.second.GetPrev()->second.m_next = &pair;
         }
-        Assume(pair.second.m_prev && pair.second.m_next);
-        pair.second.m_flags |= flags;
+        Assume(pair.second.GetPrev() && pair.second.m_next);
+        pair.second.m_prev_and_flags |= flags;
     }
 
 public:
@@ -179,40 +186,42 @@ public:
 
     void SetClean() noexcept
     {
-        if (!m_flags) return;
-        m_next->second.m_prev = m_prev;
-        m_prev->second.m_next = m_next;
-        m_flags = 0;
-        m_prev = m_next = nullptr;
+        if (!GetFlags()) return;
+        m_next->second.SetPrev(GetPrev());
+        GetPrev()->second.m_next = m_next;
+        m_prev_and_flags = 0;
+        m_next = nullptr;
     }
-    bool IsDirty() const noexcept { return m_flags & DIRTY; }
-    bool IsFresh() const noexcept { return m_flags & FRESH; }
+    bool IsDirty() const noexcept { return GetFlags() & DIRTY; }
+    bool IsFresh() const noexcept { return GetFlags() & FRESH; }
 
     //! Only call Next when this entry is DIRTY, FRESH, or both
     CoinsCachePair* Next() const noexcept
     {
-        Assume(m_flags);
+        Assume(GetFlags());
         return m_next;
     }
 
     //! Only call Prev when this entry is DIRTY, FRESH, or both
     CoinsCachePair* Prev() const noexcept
     {
-        Assume(m_flags);
-        return m_prev;
+        Assume(GetFlags());
+        return GetPrev();
     }
 
     //! Only use this for initializing the linked list sentinel
     void SelfRef(CoinsCachePair& pair) noexcept
     {
         Assume(&pair.second == this);
-        m_prev = &pair;
-        m_next = &pair;
         // Set sentinel to DIRTY so we can call Next on it
-        m_flags = DIRTY;
+        m_prev_and_flags = reinterpret_cast<uintptr_t>(&pair) | DIRTY;
+        m_next = &pair;
     }
 };
 
+static_assert(alignof(CoinsCachePair) > (CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH),
+              "flags are stored in the unused low bits of CoinsCachePair pointers");
+
 /**
  * PoolAllocator's MAX_BLOCK_SIZE_BYTES parameter here uses sizeof the data, and adds the size
  * of 4 pointers. We do not know the exact node size used in the std::unordered_node implementation
@@ -430,6 +439,16 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin);
 
+    /**
+     * Insert an unspent coin that was read from the backing view by the caller,
+     * without marking it DIRTY or FRESH. This has the same effect as a cache miss
+     * in FetchCoin, and does nothing if the outpoint is already in the cache.
+     *
+     * The coin must match the state of the base view.
+     * @sa InputFetcher
+     */
+    void EmplaceCoinFromBase(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call
@@ -0,0 +1,129 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/txospenderindex.h>
+
+#include <common/args.h>
+#include <dbwrapper.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <serialize.h>
+#include <validation.h>
+
+#include <ios>
+#include <vector>
+
+constexpr uint8_t DB_TXOSPENDER{'s'};
+
+std::unique_ptr<TxoSpenderIndex> g_txospenderindex;
+
+namespace {
+/** Key of a spent outpoint. The output index is stored as a VARINT, as almost all of them are small. */
+struct DBKey {
+    Txid hash;
+    uint32_t n;
+
+    explicit DBKey(const COutPoint& prevout) : hash{prevout.hash}, n{prevout.n} {}
+
+    SERIALIZE_METHODS(DBKey, obj)
+    {
+        uint8_t prefix{DB_TXOSPENDER};
+        READWRITE(prefix);
+        if (prefix != DB_TXOSPENDER) {
+            throw std::ios_base::failure("Invalid format for spent output index DB key");
+        }
+        READWRITE(obj.hash, VARINT(obj.n));
+    }
+};
+
+struct DBVal {
+    Txid txid;
+    int height;
+    uint256 block_hash;
+
+    SERIALIZE_METHODS(DBVal, obj) { READWRITE(obj.txid, VARINT_MODE(obj.height, VarIntMode::NONNEGATIVE_SIGNED), obj.block_hash); }
+};
+} // namespace
+
+/** Access to the spent output index database (indexes/txospenderindex/) */
+class TxoSpenderIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Write the spends of a block to the DB.
+    [[nodiscard]] bool WriteSpenders(const CBlock& block, int height, const uint256& block_hash);
+
+    /// Erase the spends of a block from the DB.
+    [[nodiscard]] bool EraseSpenders(const CBlock& block);
+};
+
+TxoSpenderIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txospenderindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool TxoSpenderIndex::DB::WriteSpenders(const CBlock& block, int height, const uint256& block_hash)
+{
+    CDBBatch batch(*this);
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            batch.Write(DBKey{txin.prevout}, DBVal{tx->GetHash(), height, block_hash});
+        }
+    }
+    return WriteBatch(batch);
+}
+
+bool TxoSpenderIndex::DB::EraseSpenders(const CBlock& block)
+{
+    CDBBatch batch(*this);
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            batch.Erase(DBKey{txin.prevout});
+        }
+    }
+    return WriteBatch(batch);
+}
+
+TxoSpenderIndex::TxoSpenderIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "txospenderindex"), m_db(std::make_unique<TxoSpenderIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+TxoSpenderIndex::~TxoSpenderIndex() = default;
+
+bool TxoSpenderIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    assert(block.data);
+    return m_db->WriteSpenders(*block.data, block.height, block.hash);
+}
+
+bool TxoSpenderIndex::CustomRewind(const interfaces::BlockRef& current_tip, const interfaces::BlockRef& new_tip)
+{
+    LOCK(cs_main);
+    const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
+    const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
+
+    do {
+        CBlock block;
+        if (!m_chainstate->m_blockman.ReadBlock(block, *iter_tip)) {
+            LogError("%s: Failed to read block %s from disk\n",
+                     __func__, iter_tip->GetBlockHash().ToString());
+            return false;
+        }
+        if (!m_db->EraseSpenders(block)) return false;
+        iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+    } while (new_tip_index != iter_tip);
+
+    return true;
+}
+
+BaseIndex::DB& TxoSpenderIndex::GetDB() const { return *m_db; }
+
+std::optional<TxoSpenderIndex::Spender> TxoSpenderIndex::FindSpender(const COutPoint& prevout) const
+{
+    DBVal value;
+    if (!m_db->Read(DBKey{prevout}, value)) return std::nullopt;
+    return Spender{value.txid, value.height, value.block_hash};
+}
@@ -0,0 +1,65 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_TXOSPENDERINDEX_H
+#define BITCOIN_INDEX_TXOSPENDERINDEX_H
+
+#include <index/base.h>
+#include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <memory>
+#include <optional>
+
+static constexpr bool DEFAULT_TXOSPENDERINDEX{false};
+
+/**
+ * TxoSpenderIndex is used to look up which transaction spent a given output.
+ * The index is written to a LevelDB database and records, for each spent
+ * outpoint, the txid of the spending transaction and the height and hash of
+ * the block it was confirmed in.
+ */
+class TxoSpenderIndex final : public BaseIndex
+{
+public:
+    struct Spender {
+        Txid txid;
+        int height;
+        uint256 block_hash;
+    };
+
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomRewind(const interfaces::BlockRef& current_tip, const interfaces::BlockRef& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit TxoSpenderIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~TxoSpenderIndex() override;
+
+    /// Look up the transaction that spent an output.
+    ///
+    /// @param[in]   prevout  The output to look up.
+    /// @return  The spending transaction's txid, block height and block hash, or std::nullopt if
+    ///          the output is not spent in the indexed chain.
+    std::optional<Spender> FindSpender(const COutPoint& prevout) const;
+};
+
+/// The global spent output index, used in gettxspendingprevout. May be null.
+extern std::unique_ptr<TxoSpenderIndex> g_txospenderindex;
+
+#endif // BITCOIN_INDEX_TXOSPENDERINDEX_H
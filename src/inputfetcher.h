@@ -0,0 +1,206 @@
+// Copyright (c) 2024-present The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INPUTFETCHER_H
+#define BITCOIN_INPUTFETCHER_H
+
+#include <coins.h>
+#include <logging.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/hasher.h>
+#include <util/threadnames.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Prefetches the inputs of a block into a CCoinsViewCache before it is connected.
+ *
+ * Without prefetching, ConnectBlock looks up every input through
+ * CCoinsViewCache::AccessCoin, and every cache miss turns into a serial
+ * database read on the thread holding cs_main. With a small coins cache (e.g.
+ * during initial block download) block connection is then bound by random
+ * read latency.
+ *
+ * FetchInputs collects all prevouts of a block that are neither created by the
+ * block itself nor already cached, reads them from the database on a pool of
+ * worker threads (the calling thread joins the pool until all reads are done),
+ * and inserts the results into the cache as unmodified entries. LevelDB
+ * supports concurrent reads, so these can overlap.
+ */
+class InputFetcher
+{
+private:
+    //! Mutex to protect the inner state
+    Mutex m_mutex;
+
+    //! Worker threads block on this when out of work
+    std::condition_variable m_worker_cv;
+
+    //! Master thread blocks on this until all workers are done with a block
+    std::condition_variable m_master_cv;
+
+    //! Incremented for every block handed to the workers.
+    uint64_t m_generation GUARDED_BY(m_mutex){0};
+
+    //! Number of worker threads that have not finished the current block yet.
+    size_t m_pending GUARDED_BY(m_mutex){0};
+
+    //! The view the current block's inputs are read from.
+    const CCoinsView* m_db GUARDED_BY(m_mutex){nullptr};
+
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+
+    /**
+     * Outpoints to fetch and their results. These are only resized by the
+     * master thread while no worker is active. While a block is being fetched,
+     * each slot is written by exactly one thread, which claims it through
+     * m_next.
+     */
+    std::vector<COutPoint> m_outpoints;
+    std::vector<std::optional<Coin>> m_coins;
+
+    //! Index of the next outpoint that has not been claimed by a thread.
+    std::atomic<size_t> m_next{0};
+
+    //! The number of outpoints a thread claims at once.
+    const size_t m_batch_size;
+
+    std::vector<std::thread> m_worker_threads;
+
+    /** Read outpoints from db until all of them have been claimed. */
+    void Work(const CCoinsView& db) noexcept
+    {
+        const size_t total{m_outpoints.size()};
+        size_t begin;
+        while ((begin = m_next.fetch_add(m_batch_size, std::memory_order_relaxed)) < total) {
+            const size_t end{std::min(begin + m_batch_size, total)};
+            for (size_t i{begin}; i < end; ++i) {
+                try {
+                    m_coins[i] = db.GetCoin(m_outpoints[i]);
+                } catch (const std::runtime_error&) {
+                    // Leave the slot empty. ConnectBlock will read this coin
+                    // again through the regular path, which deals with
+                    // database read errors.
+                }
+            }
+        }
+    }
+
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        uint64_t generation{0};
+        while (true) {
+            const CCoinsView* db;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_request_stop || m_generation != generation; });
+                if (m_request_stop) return;
+                generation = m_generation;
+                db = m_db;
+            }
+            Work(*db);
+            {
+                LOCK(m_mutex);
+                if (--m_pending == 0) m_master_cv.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit InputFetcher(size_t batch_size, int worker_threads_num)
+        : m_batch_size(batch_size)
+    {
+        if (worker_threads_num > 0) {
+            LogInfo("Input fetching uses %d additional threads", worker_threads_num);
+        }
+        m_worker_threads.reserve(worker_threads_num);
+        for (int n = 0; n < worker_threads_num; ++n) {
+            m_worker_threads.emplace_back([this, n]() {
+                util::ThreadRename(strprintf("inputfetch.%i", n));
+                Loop();
+            });
+        }
+    }
+
+    // Since this class manages its own resources, which is a thread
+    // pool `m_worker_threads`, copy and move operations are not appropriate.
+    InputFetcher(const InputFetcher&) = delete;
+    InputFetcher& operator=(const InputFetcher&) = delete;
+    InputFetcher(InputFetcher&&) = delete;
+    InputFetcher& operator=(InputFetcher&&) = delete;
+
+    /**
+     * Fetch the inputs of block that are missing from cache from db, and add
+     * them to cache. db must be the view cache is (indirectly) backed by, and
+     * neither of them may be modified by another thread during the call.
+     *
+     * This is a no-op if there are no worker threads, as ConnectBlock would
+     * perform the same reads in the same order anyway.
+     */
+    void FetchInputs(CCoinsViewCache& cache, const CCoinsView& db, const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        if (m_worker_threads.empty() || block.vtx.size() <= 1) return;
+
+        // Outputs created within the block can not be in the database yet.
+        std::unordered_set<Txid, SaltedTxidHasher> block_txids;
+        block_txids.reserve(block.vtx.size());
+        for (const auto& tx : block.vtx) {
+            block_txids.insert(tx->GetHash());
+        }
+        for (size_t i{1}; i < block.vtx.size(); ++i) {
+            for (const CTxIn& txin : block.vtx[i]->vin) {
+                if (block_txids.contains(txin.prevout.hash) || cache.HaveCoinInCache(txin.prevout)) continue;
+                m_outpoints.push_back(txin.prevout);
+            }
+        }
+        if (m_outpoints.empty()) return;
+        m_coins.resize(m_outpoints.size());
+        m_next.store(0, std::memory_order_relaxed);
+
+        {
+            LOCK(m_mutex);
+            m_db = &db;
+            m_pending = m_worker_threads.size();
+            ++m_generation;
+        }
+        m_worker_cv.notify_all();
+        Work(db);
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_master_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_pending == 0; });
+            m_db = nullptr;
+        }
+
+        for (size_t i{0}; i < m_outpoints.size(); ++i) {
+            if (m_coins[i]) cache.EmplaceCoinFromBase(m_outpoints[i], std::move(*m_coins[i]));
+        }
+        m_outpoints.clear();
+        m_coins.clear();
+    }
+
+    ~InputFetcher()
+    {
+        WITH_LOCK(m_mutex, m_request_stop = true);
+        m_worker_cv.notify_all();
+        for (std::thread& t : m_worker_threads) {
+            t.join();
+        }
+    }
+
+    bool HasThreads() const { return !m_worker_threads.empty(); }
+};
+
+#endif // BITCOIN_INPUTFETCHER_H
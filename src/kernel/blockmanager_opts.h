@@ -9,6 +9,7 @@
 #include <kernel/notifications_interface.h>
 #include <util/fs.h>
 
+#include <cstddef>
 #include <cstdint>
 
 class CChainParams;
@@ -16,6 +17,8 @@ class CChainParams;
 namespace kernel {
 
 static constexpr bool DEFAULT_XOR_BLOCKSDIR{true};
+/** -blockservecache default, in MiB. Disabled by default, as the memory is not taken from -dbcache. */
+static constexpr int64_t DEFAULT_BLOCK_SERVE_CACHE_MB{0};
 
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
@@ -26,6 +29,8 @@ struct BlockManagerOpts {
     bool use_xor{DEFAULT_XOR_BLOCKSDIR};
     uint64_t prune_target{0};
     bool fast_prune{false};
+    //! Memory to use for recently served blocks, see BlockManager::ReadRawBlockCached()
+    size_t serve_cache_bytes{DEFAULT_BLOCK_SERVE_CACHE_MB << 20};
     const fs::path blocks_dir;
     Notifications& notifications;
     DBParams block_tree_db_params;
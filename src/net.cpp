@@ -127,7 +127,9 @@ std::string strSubVersion;
 
 size_t CSerializedNetMsg::GetMemoryUsage() const noexcept
 {
-    return sizeof(*this) + memusage::DynamicUsage(m_type) + memusage::DynamicUsage(data);
+    size_t usage{sizeof(*this) + memusage::DynamicUsage(m_type) + memusage::DynamicUsage(data)};
+    if (m_shared_payload) usage += memusage::DynamicUsage(m_shared_payload) + memusage::DynamicUsage(m_shared_payload->data);
+    return usage;
 }
 
 size_t CNetMessage::GetMemoryUsage() const noexcept
@@ -843,13 +845,13 @@ bool V1Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     AssertLockNotHeld(m_send_mutex);
     // Determine whether a new message can be set.
     LOCK(m_send_mutex);
-    if (m_sending_header || m_bytes_sent < m_message_to_send.data.size()) return false;
+    if (m_sending_header || m_bytes_sent < m_message_to_send.Payload().size()) return false;
 
-    // create dbl-sha256 checksum
-    uint256 hash = Hash(msg.data);
+    // create dbl-sha256 checksum, which is computed only once for a shared payload
+    const uint256 hash = msg.m_shared_payload ? msg.m_shared_payload->hash : Hash(msg.data);
 
     // create header
-    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.data.size());
+    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.Payload().size());
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
     // serialize header
@@ -871,11 +873,11 @@ Transport::BytesToSend V1Transport::GetBytesToSend(bool have_next_message) const
         return {Span{m_header_to_send}.subspan(m_bytes_sent),
                 // We have more to send after the header if the message has payload, or if there
                 // is a next message after that.
-                have_next_message || !m_message_to_send.data.empty(),
+                have_next_message || !m_message_to_send.Payload().empty(),
                 m_message_to_send.m_type
                };
     } else {
-        return {Span{m_message_to_send.data}.subspan(m_bytes_sent),
+        return {m_message_to_send.Payload().subspan(m_bytes_sent),
                 // We only have more to send after this message's payload if there is another
                 // message.
                 have_next_message,
@@ -893,9 +895,10 @@ void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
         // We're done sending a message's header. Switch to sending its data bytes.
         m_sending_header = false;
         m_bytes_sent = 0;
-    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.data.size()) {
+    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.Payload().size()) {
         // We're done sending a message's data. Wipe the data vector to reduce memory consumption.
         ClearShrink(m_message_to_send.data);
+        m_message_to_send.m_shared_payload.reset();
         m_bytes_sent = 0;
     }
 }
@@ -1489,17 +1492,18 @@ bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     if (!(m_send_state == SendState::READY && m_send_buffer.empty())) return false;
     // Construct contents (encoding message type + payload).
     std::vector<uint8_t> contents;
+    const auto payload{msg.Payload()};
     auto short_message_id = V2_MESSAGE_MAP(msg.m_type);
     if (short_message_id) {
-        contents.resize(1 + msg.data.size());
+        contents.resize(1 + payload.size());
         contents[0] = *short_message_id;
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1);
+        std::copy(payload.begin(), payload.end(), contents.begin() + 1);
     } else {
         // Initialize with zeroes, and then write the message type string starting at offset 1.
         // This means contents[0] and the unused positions in contents[1..13] remain 0x00.
-        contents.resize(1 + CMessageHeader::MESSAGE_TYPE_SIZE + msg.data.size(), 0);
+        contents.resize(1 + CMessageHeader::MESSAGE_TYPE_SIZE + payload.size(), 0);
         std::copy(msg.m_type.begin(), msg.m_type.end(), contents.data() + 1);
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1 + CMessageHeader::MESSAGE_TYPE_SIZE);
+        std::copy(payload.begin(), payload.end(), contents.begin() + 1 + CMessageHeader::MESSAGE_TYPE_SIZE);
     }
     // Construct ciphertext in send buffer.
     m_send_buffer.resize(contents.size() + BIP324Cipher::EXPANSION);
@@ -1507,6 +1511,7 @@ bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     m_send_type = msg.m_type;
     // Release memory
     ClearShrink(msg.data);
+    msg.m_shared_payload.reset();
     return true;
 }
 
@@ -2242,6 +2247,22 @@ void CConnman::WakeMessageHandler()
     condMsgProc.notify_one();
 }
 
+void CConnman::WakeMessageServer(NodeId id)
+{
+    const int index{static_cast<int>(id % m_msg_serve_threads)};
+    WITH_LOCK(m_msg_serve_mutex, ++m_msg_serve_wake[index]);
+    m_msg_serve_cvs[index].notify_one();
+}
+
+void CConnman::WakeMessageServers()
+{
+    {
+        LOCK(m_msg_serve_mutex);
+        for (int i = 0; i < m_msg_serve_threads; ++i) ++m_msg_serve_wake[i];
+    }
+    for (int i = 0; i < m_msg_serve_threads; ++i) m_msg_serve_cvs[i].notify_one();
+}
+
 void CConnman::ThreadDNSAddressSeed()
 {
     int outbound_connection_count = 0;
@@ -3068,6 +3089,30 @@ void CConnman::ThreadMessageHandler()
     }
 }
 
+void CConnman::ThreadMessageServer(int index)
+{
+    uint64_t wake{WITH_LOCK(m_msg_serve_mutex, return m_msg_serve_wake[index])};
+    while (!flagInterruptMsgProc) {
+        bool more_work{false};
+        {
+            const NodesSnapshot snap{*this, /*shuffle=*/false};
+            for (CNode* pnode : snap.Nodes()) {
+                // Each node is served by a single thread, so that its
+                // requests are answered in order.
+                if (pnode->fDisconnect || pnode->GetId() % m_msg_serve_threads != index) continue;
+                more_work |= m_msgproc->ServeMessages(pnode, flagInterruptMsgProc) && !pnode->fPauseSend;
+                if (flagInterruptMsgProc) return;
+            }
+        }
+
+        WAIT_LOCK(m_msg_serve_mutex, lock);
+        if (!more_work) {
+            m_msg_serve_cvs[index].wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [&]() EXCLUSIVE_LOCKS_REQUIRED(m_msg_serve_mutex) { return flagInterruptMsgProc || m_msg_serve_wake[index] != wake; });
+        }
+        wake = m_msg_serve_wake[index];
+    }
+}
+
 void CConnman::ThreadI2PAcceptIncoming()
 {
     static constexpr auto err_wait_begin = 1s;
@@ -3379,6 +3424,9 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
 
     // Process messages
     threadMessageHandler = std::thread(&util::TraceThread, "msghand", [this] { ThreadMessageHandler(); });
+    for (int i = 0; i < m_msg_serve_threads; ++i) {
+        m_threads_msg_serve.emplace_back(&util::TraceThread, strprintf("msgserve.%i", i), [this, i] { ThreadMessageServer(i); });
+    }
 
     if (m_i2p_sam_session) {
         threadI2PAcceptIncoming =
@@ -3419,6 +3467,7 @@ void CConnman::Interrupt()
         flagInterruptMsgProc = true;
     }
     condMsgProc.notify_all();
+    WakeMessageServers();
 
     interruptNet();
     g_socks5_interrupt();
@@ -3443,6 +3492,10 @@ void CConnman::StopThreads()
     }
     if (threadMessageHandler.joinable())
         threadMessageHandler.join();
+    for (std::thread& thread : m_threads_msg_serve) {
+        thread.join();
+    }
+    m_threads_msg_serve.clear();
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -3870,10 +3923,10 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
 void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
-    size_t nMessageSize = msg.data.size();
+    size_t nMessageSize = msg.Payload().size();
     LogDebug(BCLog::NET, "sending %s (%d bytes) peer=%d\n", msg.m_type, nMessageSize, pnode->GetId());
     if (gArgs.GetBoolArg("-capturemessages", false)) {
-        CaptureMessage(pnode->addr, msg.m_type, msg.data, /*is_incoming=*/false);
+        CaptureMessage(pnode->addr, msg.m_type, msg.Payload(), /*is_incoming=*/false);
     }
 
     TRACEPOINT(net, outbound_message,
@@ -3881,8 +3934,8 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         pnode->m_addr_name.c_str(),
         pnode->ConnectionTypeAsString().c_str(),
         msg.m_type.c_str(),
-        msg.data.size(),
-        msg.data.data()
+        nMessageSize,
+        msg.Payload().data()
     );
 
     size_t nBytesSent = 0;
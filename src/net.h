@@ -32,6 +32,8 @@
 #include <util/sock.h>
 #include <util/threadinterrupt.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -44,6 +46,7 @@
 #include <queue>
 #include <thread>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 class AddrMan;
@@ -91,6 +94,10 @@ static constexpr bool DEFAULT_DNSSEED{true};
 static constexpr bool DEFAULT_FIXEDSEEDS{true};
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** -msgservethreads default: serve block requests from the message handler thread */
+static constexpr int DEFAULT_MSG_SERVE_THREADS{0};
+/** Maximum number of threads serving block requests */
+static constexpr int MAX_MSG_SERVE_THREADS{16};
 
 static constexpr bool DEFAULT_V2_TRANSPORT{true};
 
@@ -111,6 +118,19 @@ struct AddedNodeInfo {
 class CNodeStats;
 class CClientUIInterface;
 
+/**
+ * Payload of a network message that is sent to several peers, e.g. a newly
+ * found block. It is immutable, so all copies of the message can share it.
+ */
+struct SharedNetMsgPayload {
+    explicit SharedNetMsgPayload(std::vector<unsigned char>&& data_in)
+        : data{std::move(data_in)}, hash{Hash(data)} {}
+
+    const std::vector<unsigned char> data;
+    //! Double-SHA256 of data, which the v1 message header checksum is taken from.
+    const uint256 hash;
+};
+
 struct CSerializedNetMsg {
     CSerializedNetMsg() = default;
     CSerializedNetMsg(CSerializedNetMsg&&) = default;
@@ -123,14 +143,35 @@ struct CSerializedNetMsg {
     {
         CSerializedNetMsg copy;
         copy.data = data;
+        copy.m_shared_payload = m_shared_payload;
         copy.m_type = m_type;
         return copy;
     }
 
+    /**
+     * Move the payload into a buffer shared by all copies of this message, so
+     * that a message sent to many peers is only held in memory once.
+     */
+    void Share()
+    {
+        if (!m_shared_payload) m_shared_payload = std::make_shared<const SharedNetMsgPayload>(std::exchange(data, {}));
+    }
+
+    Span<const unsigned char> Payload() const noexcept
+    {
+        return m_shared_payload ? Span{m_shared_payload->data} : Span{data};
+    }
+
     std::vector<unsigned char> data;
+    //! If set, the payload of this message, and data is empty.
+    std::shared_ptr<const SharedNetMsgPayload> m_shared_payload;
     std::string m_type;
 
-    /** Compute total memory usage of this object (own memory + any dynamic memory). */
+    /**
+     * Compute total memory usage of this object (own memory + any dynamic memory).
+     * A shared payload is counted in full, as it is what a peer's send buffer
+     * limit is about.
+     */
     size_t GetMemoryUsage() const noexcept;
 };
 
@@ -1039,6 +1080,17 @@ public:
     */
     virtual bool SendMessages(CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex) = 0;
 
+    /**
+    * Serve requests of a given node that ProcessMessages handed off to the
+    * message serving threads. This does not touch state that is only accessed
+    * via the msg processing thread, so different nodes can be served
+    * concurrently. Each node is only ever served by one thread.
+    *
+    * @param[in]   pnode           The node whose requests to serve.
+    * @param[in]   interrupt       Interrupt condition for processing threads
+    * @return                      True if there is more work to be done
+    */
+    virtual bool ServeMessages(CNode* pnode, std::atomic<bool>& interrupt) EXCLUSIVE_LOCKS_REQUIRED(!g_msgproc_mutex) = 0;
 
 protected:
     /**
@@ -1061,6 +1113,7 @@ public:
         BanMan* m_banman = nullptr;
         unsigned int nSendBufferMaxSize = 0;
         unsigned int nReceiveFloodSize = 0;
+        int m_msg_serve_threads = 0;
         uint64_t nMaxOutboundLimit = 0;
         int64_t m_peer_connect_timeout = DEFAULT_PEER_CONNECT_TIMEOUT;
         std::vector<std::string> vSeedNodes;
@@ -1096,6 +1149,7 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        m_msg_serve_threads = std::clamp(connOptions.m_msg_serve_threads, 0, MAX_MSG_SERVE_THREADS);
         m_peer_connect_timeout = std::chrono::seconds{connOptions.m_peer_connect_timeout};
         {
             LOCK(m_total_bytes_sent_mutex);
@@ -1132,7 +1186,7 @@ public:
         StopNodes();
     };
 
-    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc, !m_msg_serve_mutex);
     bool GetNetworkActive() const { return fNetworkActive; };
     bool GetUseAddrmanOutgoing() const { return m_use_addrman_outgoing; };
     void SetNetworkActive(bool active);
@@ -1267,6 +1321,11 @@ public:
 
     void WakeMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
 
+    /** Number of threads calling NetEventsInterface::ServeMessages(). If 0, nothing may be handed off to them. */
+    int GetMessageServeThreads() const { return m_msg_serve_threads; }
+    /** Wake the message serving thread that serves the given node. */
+    void WakeMessageServer(NodeId id) EXCLUSIVE_LOCKS_REQUIRED(!m_msg_serve_mutex);
+
     /** Return true if we should disconnect the peer for failing an inactivity check. */
     bool ShouldRunInactivityChecks(const CNode& node, std::chrono::seconds now) const;
 
@@ -1299,6 +1358,8 @@ private:
     void ProcessAddrFetch() EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_unused_i2p_sessions_mutex);
     void ThreadOpenConnections(std::vector<std::string> connect, Span<const std::string> seed_nodes) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_added_nodes_mutex, !m_nodes_mutex, !m_unused_i2p_sessions_mutex, !m_reconnections_mutex);
     void ThreadMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    void ThreadMessageServer(int index) EXCLUSIVE_LOCKS_REQUIRED(!m_msg_serve_mutex);
+    void WakeMessageServers() EXCLUSIVE_LOCKS_REQUIRED(!m_msg_serve_mutex);
     void ThreadI2PAcceptIncoming();
     void AcceptConnection(const ListenSocket& hListenSocket);
 
@@ -1540,6 +1601,14 @@ private:
     Mutex mutexMsgProc;
     std::atomic<bool> flagInterruptMsgProc{false};
 
+    /** Number of message serving threads, see GetMessageServeThreads(). */
+    int m_msg_serve_threads{0};
+    /** Incremented for waking each message serving thread. */
+    std::array<uint64_t, MAX_MSG_SERVE_THREADS> m_msg_serve_wake GUARDED_BY(m_msg_serve_mutex){};
+    /** One per message serving thread, so that handing off a node only wakes the thread serving it. */
+    std::array<std::condition_variable, MAX_MSG_SERVE_THREADS> m_msg_serve_cvs;
+    Mutex m_msg_serve_mutex;
+
     /**
      * This is signaled when network activity should cease.
      * A pointer to it is saved in `m_i2p_sam_session`, so make sure that
@@ -1560,6 +1629,7 @@ private:
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
     std::thread threadMessageHandler;
+    std::vector<std::thread> m_threads_msg_serve;
     std::thread threadI2PAcceptIncoming;
 
     /** flag for deciding to connect to an extra outbound peer,
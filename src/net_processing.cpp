@@ -48,7 +48,6 @@
 
 #include <algorithm>
 #include <atomic>
-#include <future>
 #include <memory>
 #include <optional>
 #include <ranges>
@@ -359,6 +358,9 @@ struct Peer {
     Mutex m_getdata_requests_mutex;
     /** Work queue of items requested by this peer **/
     std::deque<CInv> m_getdata_requests GUARDED_BY(m_getdata_requests_mutex);
+    /** Set while the block request at the front of m_getdata_requests is left
+     *  to a message serving thread, to the nonce for a compact block reply. **/
+    std::optional<uint64_t> m_getdata_serve_nonce GUARDED_BY(m_getdata_requests_mutex);
 
     /** Time of the last getheaders message to this peer */
     NodeClock::time_point m_last_getheaders_timestamp GUARDED_BY(NetEventsInterface::g_msgproc_mutex){};
@@ -496,6 +498,8 @@ public:
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex, !m_headers_presync_mutex, g_msgproc_mutex, !m_tx_download_mutex);
     bool SendMessages(CNode* pto) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex, g_msgproc_mutex, !m_tx_download_mutex);
+    bool ServeMessages(CNode* pfrom, std::atomic<bool>& interrupt) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex, !g_msgproc_mutex);
 
     /** Implement PeerManager */
     void StartScheduledTasks(CScheduler& scheduler) override;
@@ -827,6 +831,20 @@ private:
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> m_most_recent_compact_block GUARDED_BY(m_most_recent_block_mutex);
     uint256 m_most_recent_block_hash GUARDED_BY(m_most_recent_block_mutex);
     std::unique_ptr<const std::map<uint256, CTransactionRef>> m_most_recent_block_txs GUARDED_BY(m_most_recent_block_mutex);
+    /** Serialized m_most_recent_compact_block, created when it is first sent. */
+    std::optional<CSerializedNetMsg> m_most_recent_compact_block_msg GUARDED_BY(m_most_recent_block_mutex);
+    /** Serialized m_most_recent_block with witnesses, created when it is first requested. */
+    std::optional<CSerializedNetMsg> m_most_recent_block_msg GUARDED_BY(m_most_recent_block_mutex);
+
+    /**
+     * Return a block message for block, which must be the most recent block
+     * or one that was replaced since. The serialization of the most recent
+     * block is shared by all peers it is sent to.
+     */
+    CSerializedNetMsg GetRecentBlockMsg(const std::shared_ptr<const CBlock>& block) EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex);
+
+    /** Same as GetRecentBlockMsg(), for the compact block of the most recent block. */
+    CSerializedNetMsg GetRecentCompactBlockMsg(const std::shared_ptr<const CBlockHeaderAndShortTxIDs>& cmpctblock) EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex);
 
     // Data about the low-work headers synchronization, aggregated from all peers' HeadersSyncStates.
     /** Mutex guarding the other m_headers_presync_* variables. */
@@ -974,8 +992,14 @@ private:
      */
     bool BlockRequestAllowed(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AlreadyHaveBlock(const uint256& block_hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
-    void ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex, !m_most_recent_block_mutex);
+    /**
+     * Send a requested block to a peer. This does not require
+     * g_msgproc_mutex, so that it can run on a message serving thread.
+     *
+     * @param[in] cmpctblock_nonce  Nonce for the short ids if the block is sent as a compact block
+     */
+    void ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv, uint64_t cmpctblock_nonce)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex);
 
     /**
      * Validation logic for compact filters request handling.
@@ -1894,7 +1918,7 @@ PeerManagerImpl::PeerManagerImpl(CConnman& connman, AddrMan& addrman,
       m_banman(banman),
       m_chainman(chainman),
       m_mempool(pool),
-      m_txdownloadman(node::TxDownloadOptions{pool, m_rng, opts.max_orphan_txs, opts.deterministic_rng}),
+      m_txdownloadman(node::TxDownloadOptions{pool, m_rng, opts.max_orphan_txs, opts.deterministic_rng, &chainman}),
       m_warnings{warnings},
       m_opts{opts}
 {
@@ -1992,8 +2016,8 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
     if (!DeploymentActiveAt(*pindex, m_chainman, Consensus::DEPLOYMENT_SEGWIT)) return;
 
     uint256 hashBlock(pblock->GetHash());
-    const std::shared_future<CSerializedNetMsg> lazy_ser{
-        std::async(std::launch::deferred, [&] { return NetMsg::Make(NetMsgType::CMPCTBLOCK, *pcmpctblock); })};
+    // Only serialized once a peer is sent the compact block.
+    std::optional<CSerializedNetMsg> ser_cmpctblock;
 
     {
         auto most_recent_block_txs = std::make_unique<std::map<uint256, CTransactionRef>>();
@@ -2007,9 +2031,11 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
         m_most_recent_block = pblock;
         m_most_recent_compact_block = pcmpctblock;
         m_most_recent_block_txs = std::move(most_recent_block_txs);
+        m_most_recent_compact_block_msg.reset();
+        m_most_recent_block_msg.reset();
     }
 
-    m_connman.ForEachNode([this, pindex, &lazy_ser, &hashBlock](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+    m_connman.ForEachNode([this, pindex, &pcmpctblock, &ser_cmpctblock, &hashBlock](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
 
         if (pnode->GetCommonVersion() < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
@@ -2023,8 +2049,8 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
             LogDebug(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerManager::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
 
-            const CSerializedNetMsg& ser_cmpctblock{lazy_ser.get()};
-            PushMessage(*pnode, ser_cmpctblock.Copy());
+            if (!ser_cmpctblock) ser_cmpctblock = GetRecentCompactBlockMsg(pcmpctblock);
+            PushMessage(*pnode, ser_cmpctblock->Copy());
             state.pindexBestHeaderSent = pindex;
         }
     });
@@ -2191,7 +2217,7 @@ void PeerManagerImpl::RelayAddress(NodeId originator,
     }
 }
 
-void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv)
+void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv, uint64_t cmpctblock_nonce)
 {
     std::shared_ptr<const CBlock> a_recent_block;
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> a_recent_compact_block;
@@ -2272,8 +2298,8 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     } else if (inv.IsMsgWitnessBlk()) {
         // Fast-path: in this case it is possible to serve the block directly from disk,
         // as the network format matches the format on disk
-        std::vector<uint8_t> block_data;
-        if (!m_chainman.m_blockman.ReadRawBlock(block_data, block_pos)) {
+        const auto block_data{m_chainman.m_blockman.ReadRawBlockCached(block_pos)};
+        if (!block_data) {
             if (WITH_LOCK(m_chainman.GetMutex(), return m_chainman.m_blockman.IsBlockPruned(*pindex))) {
                 LogDebug(BCLog::NET, "Block was pruned before it could be read, %s\n", pfrom.DisconnectMsg(fLogIPs));
             } else {
@@ -2282,12 +2308,12 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             pfrom.fDisconnect = true;
             return;
         }
-        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, Span{block_data});
+        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, Span{*block_data});
         // Don't set pblock as we've sent the block
     } else {
         // Send block from disk
         std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-        if (!m_chainman.m_blockman.ReadBlock(*pblockRead, block_pos)) {
+        if (!m_chainman.m_blockman.ReadBlockCached(*pblockRead, block_pos)) {
             if (WITH_LOCK(m_chainman.GetMutex(), return m_chainman.m_blockman.IsBlockPruned(*pindex))) {
                 LogDebug(BCLog::NET, "Block was pruned before it could be read, %s\n", pfrom.DisconnectMsg(fLogIPs));
             } else {
@@ -2302,7 +2328,8 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
         if (inv.IsMsgBlk()) {
             MakeAndPushMessage(pfrom, NetMsgType::BLOCK, TX_NO_WITNESS(*pblock));
         } else if (inv.IsMsgWitnessBlk()) {
-            MakeAndPushMessage(pfrom, NetMsgType::BLOCK, TX_WITH_WITNESS(*pblock));
+            // Only a recent block gets here, see the fast-path above.
+            PushMessage(pfrom, GetRecentBlockMsg(pblock));
         } else if (inv.IsMsgFilteredBlk()) {
             bool sendMerkleBlock = false;
             CMerkleBlock merkleBlock;
@@ -2334,9 +2361,9 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             // instead we respond with the full, non-compact block.
             if (can_direct_fetch && pindex->nHeight >= tip->nHeight - MAX_CMPCTBLOCK_DEPTH) {
                 if (a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
-                    MakeAndPushMessage(pfrom, NetMsgType::CMPCTBLOCK, *a_recent_compact_block);
+                    PushMessage(pfrom, GetRecentCompactBlockMsg(a_recent_compact_block));
                 } else {
-                    CBlockHeaderAndShortTxIDs cmpctblock{*pblock, m_rng.rand64()};
+                    CBlockHeaderAndShortTxIDs cmpctblock{*pblock, cmpctblock_nonce};
                     MakeAndPushMessage(pfrom, NetMsgType::CMPCTBLOCK, cmpctblock);
                 }
             } else {
@@ -2360,6 +2387,34 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     }
 }
 
+CSerializedNetMsg PeerManagerImpl::GetRecentBlockMsg(const std::shared_ptr<const CBlock>& block)
+{
+    {
+        LOCK(m_most_recent_block_mutex);
+        if (m_most_recent_block == block && m_most_recent_block_msg) return m_most_recent_block_msg->Copy();
+    }
+    // Serialize without holding the lock. If several peers request the block
+    // at once, it may be serialized more than once, but only one is kept.
+    CSerializedNetMsg msg{NetMsg::Make(NetMsgType::BLOCK, TX_WITH_WITNESS(*block))};
+    msg.Share();
+    LOCK(m_most_recent_block_mutex);
+    if (m_most_recent_block == block && !m_most_recent_block_msg) m_most_recent_block_msg = msg.Copy();
+    return msg;
+}
+
+CSerializedNetMsg PeerManagerImpl::GetRecentCompactBlockMsg(const std::shared_ptr<const CBlockHeaderAndShortTxIDs>& cmpctblock)
+{
+    {
+        LOCK(m_most_recent_block_mutex);
+        if (m_most_recent_compact_block == cmpctblock && m_most_recent_compact_block_msg) return m_most_recent_compact_block_msg->Copy();
+    }
+    CSerializedNetMsg msg{NetMsg::Make(NetMsgType::CMPCTBLOCK, *cmpctblock)};
+    msg.Share();
+    LOCK(m_most_recent_block_mutex);
+    if (m_most_recent_compact_block == cmpctblock && !m_most_recent_compact_block_msg) m_most_recent_compact_block_msg = msg.Copy();
+    return msg;
+}
+
 CTransactionRef PeerManagerImpl::FindTxForGetData(const Peer::TxRelay& tx_relay, const GenTxid& gtxid)
 {
     // If a tx was in the mempool prior to the last INV for this peer, permit the request.
@@ -2384,6 +2439,9 @@ void PeerManagerImpl::ProcessGetData(CNode& pfrom, Peer& peer, const std::atomic
 {
     AssertLockNotHeld(cs_main);
 
+    // A message serving thread is still busy with the front of the queue.
+    if (peer.m_getdata_serve_nonce) return;
+
     auto tx_relay = peer.GetTxRelay();
 
     std::deque<CInv>::iterator it = peer.m_getdata_requests.begin();
@@ -2420,12 +2478,21 @@ void PeerManagerImpl::ProcessGetData(CNode& pfrom, Peer& peer, const std::atomic
     // Only process one BLOCK item per call, since they're uncommon and can be
     // expensive to process.
     if (it != peer.m_getdata_requests.end() && !pfrom.fPauseSend) {
-        const CInv &inv = *it++;
-        if (inv.IsGenBlkMsg()) {
-            ProcessGetBlockData(pfrom, peer, inv);
+        if (it->IsGenBlkMsg() && m_connman.GetMessageServeThreads() > 0) {
+            // Reading and sending the block does not need to hold up other
+            // peers, so leave it to a message serving thread. The request
+            // stays at the front of the queue until the block has been sent,
+            // which holds back later requests and messages from this peer.
+            peer.m_getdata_serve_nonce = m_rng.rand64();
+            m_connman.WakeMessageServer(pfrom.GetId());
+        } else {
+            const CInv &inv = *it++;
+            if (inv.IsGenBlkMsg()) {
+                ProcessGetBlockData(pfrom, peer, inv, m_rng.rand64());
+            }
+            // else: If the first item on the queue is an unknown type, we erase it
+            // and continue processing the queue on the next call.
         }
-        // else: If the first item on the queue is an unknown type, we erase it
-        // and continue processing the queue on the next call.
     }
 
     peer.m_getdata_requests.erase(peer.m_getdata_requests.begin(), it);
@@ -4101,7 +4168,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
         if (!block_pos.IsNull()) {
             CBlock block;
-            const bool ret{m_chainman.m_blockman.ReadBlock(block, block_pos)};
+            const bool ret{m_chainman.m_blockman.ReadBlockCached(block, block_pos)};
             // If height is above MAX_BLOCKTXN_DEPTH then this block cannot get
             // pruned after we release cs_main above, so this read should never fail.
             assert(ret);
@@ -4928,6 +4995,39 @@ bool PeerManagerImpl::MaybeDiscourageAndDisconnect(CNode& pnode, Peer& peer)
     return true;
 }
 
+bool PeerManagerImpl::ServeMessages(CNode* pfrom, std::atomic<bool>& interruptMsgProc)
+{
+    AssertLockNotHeld(g_msgproc_mutex);
+
+    PeerRef peer = GetPeerRef(pfrom->GetId());
+    if (peer == nullptr) return false;
+
+    // The send buffer provides backpressure. If there's no space in the
+    // buffer, pause serving until the next call.
+    if (interruptMsgProc || pfrom->fPauseSend) return false;
+
+    CInv inv;
+    uint64_t cmpctblock_nonce;
+    {
+        LOCK(peer->m_getdata_requests_mutex);
+        if (!peer->m_getdata_serve_nonce) return false;
+        inv = peer->m_getdata_requests.front();
+        cmpctblock_nonce = *peer->m_getdata_serve_nonce;
+    }
+
+    // Don't hold m_getdata_requests_mutex while reading the block, so that
+    // the message handler thread can keep queueing requests from this peer.
+    ProcessGetBlockData(*pfrom, *peer, inv, cmpctblock_nonce);
+
+    {
+        LOCK(peer->m_getdata_requests_mutex);
+        peer->m_getdata_requests.pop_front();
+        peer->m_getdata_serve_nonce.reset();
+    }
+    m_connman.WakeMessageHandler();
+    return false;
+}
+
 bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgProc)
 {
     AssertLockNotHeld(m_tx_download_mutex);
@@ -4958,7 +5058,9 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     // and prevents m_getdata_requests to grow unbounded
     {
         LOCK(peer->m_getdata_requests_mutex);
-        if (!peer->m_getdata_requests.empty()) return true;
+        // If a message serving thread is busy with the queue, it wakes us up
+        // once it is done.
+        if (!peer->m_getdata_requests.empty()) return !peer->m_getdata_serve_nonce;
     }
 
     // Don't bother if send buffer is too full to respond anyway
@@ -4991,7 +5093,7 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
         if (interruptMsgProc) return false;
         {
             LOCK(peer->m_getdata_requests_mutex);
-            if (!peer->m_getdata_requests.empty()) fMoreWork = true;
+            if (!peer->m_getdata_requests.empty() && !peer->m_getdata_serve_nonce) fMoreWork = true;
         }
         // Does this peer has an orphan ready to reconsider?
         // (Note: we may have provided a parent for an orphan provided
@@ -5593,15 +5695,15 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     LogDebug(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", __func__,
                             vHeaders.front().GetHash().ToString(), pto->GetId());
 
-                    std::optional<CSerializedNetMsg> cached_cmpctblock_msg;
+                    std::shared_ptr<const CBlockHeaderAndShortTxIDs> cached_cmpctblock;
                     {
                         LOCK(m_most_recent_block_mutex);
                         if (m_most_recent_block_hash == pBestIndex->GetBlockHash()) {
-                            cached_cmpctblock_msg = NetMsg::Make(NetMsgType::CMPCTBLOCK, *m_most_recent_compact_block);
+                            cached_cmpctblock = m_most_recent_compact_block;
                         }
                     }
-                    if (cached_cmpctblock_msg.has_value()) {
-                        PushMessage(*pto, std::move(cached_cmpctblock_msg.value()));
+                    if (cached_cmpctblock) {
+                        PushMessage(*pto, GetRecentCompactBlockMsg(cached_cmpctblock));
                     } else {
                         CBlock block;
                         const bool ret{m_chainman.m_blockman.ReadBlock(block, *pBestIndex)};
@@ -35,6 +35,13 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Op
 
     if (auto value{args.GetBoolArg("-fastprune")}) opts.fast_prune = *value;
 
+    if (auto value{args.GetIntArg("-blockservecache")}) {
+        if (*value < 0) {
+            return util::Error{_("-blockservecache cannot be configured with a negative value.")};
+        }
+        opts.serve_cache_bytes = size_t(*value) << 20;
+    }
+
     ReadDatabaseArgs(args, opts.block_tree_db_params.options);
 
     return {};
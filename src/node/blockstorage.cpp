@@ -6,8 +6,10 @@
 
 #include <arith_uint256.h>
 #include <chain.h>
+#include <consensus/consensus.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
 #include <dbwrapper.h>
 #include <flatfile.h>
 #include <hash.h>
@@ -16,6 +18,7 @@
 #include <kernel/messagestartchars.h>
 #include <kernel/notifications_interface.h>
 #include <logging.h>
+#include <memusage.h>
 #include <pow.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -31,14 +34,20 @@
 #include <util/batchpriority.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/fs_helpers.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstddef>
 #include <map>
+#include <numeric>
 #include <ranges>
+#include <thread>
 #include <unordered_map>
 
 namespace kernel {
@@ -188,6 +197,34 @@ std::vector<CBlockIndex*> BlockManager::GetAllBlockIndices()
     return rv;
 }
 
+std::vector<CBlockIndex*> BlockManager::GetAllBlockIndicesByHeight()
+{
+    AssertLockHeld(cs_main);
+    std::vector<CBlockIndex*> all{GetAllBlockIndices()};
+    int max_height{-1};
+    for (const CBlockIndex* pindex : all) {
+        max_height = std::max(max_height, pindex->nHeight);
+        if (pindex->nHeight < 0) max_height = std::numeric_limits<int>::max();
+    }
+    // Heights outside [0, size) imply a gap (or a corrupt index); fall back to
+    // a comparison sort rather than allocating a bucket per height.
+    if (static_cast<size_t>(max_height) >= all.size()) {
+        std::sort(all.begin(), all.end(), CBlockIndexHeightOnlyComparator());
+        return all;
+    }
+    // Counting sort: offsets[h] is where the first block at height h goes.
+    std::vector<size_t> offsets(max_height + 2, 0);
+    for (const CBlockIndex* pindex : all) {
+        ++offsets[pindex->nHeight + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<CBlockIndex*> sorted(all.size());
+    for (CBlockIndex* pindex : all) {
+        sorted[offsets[pindex->nHeight]++] = pindex;
+    }
+    return sorted;
+}
+
 CBlockIndex* BlockManager::LookupBlockIndex(const uint256& hash)
 {
     AssertLockHeld(cs_main);
@@ -427,9 +464,7 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
     Assert(m_snapshot_height.has_value() == snapshot_blockhash.has_value());
 
     // Calculate nChainWork
-    std::vector<CBlockIndex*> vSortedByHeight{GetAllBlockIndices()};
-    std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
-              CBlockIndexHeightOnlyComparator());
+    std::vector<CBlockIndex*> vSortedByHeight{GetAllBlockIndicesByHeight()};
 
     CBlockIndex* previous_index{nullptr};
     for (CBlockIndex* pindex : vSortedByHeight) {
@@ -785,6 +820,9 @@ void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
             LogDebug(BCLog::BLOCKSTORAGE, "Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
         }
     }
+    // Only drop cached blocks once the files are gone, so that a block read
+    // from them in the meantime is not added back by ReadRawBlockCached.
+    m_serve_cache.EraseFiles(setFilesToPrune);
 }
 
 AutoFile BlockManager::OpenBlockFile(const FlatFilePos& pos, bool fReadOnly) const
@@ -1000,30 +1038,50 @@ bool BlockManager::ReadBlock(CBlock& block, const FlatFilePos& pos) const
 {
     block.SetNull();
 
-    // Open history file to read
-    AutoFile filein{OpenBlockFile(pos, true)};
-    if (filein.IsNull()) {
-        LogError("%s: OpenBlockFile failed for %s\n", __func__, pos.ToString());
+    // Read the serialized block with a single read and de-obfuscation pass,
+    // then deserialize it from memory. Deserializing straight from the file
+    // would issue a small read (and XOR) for every field of every transaction.
+    std::vector<uint8_t> block_data;
+    if (!ReadRawBlock(block_data, pos)) {
         return false;
     }
+    return DeserializeBlock(block, block_data, pos, __func__);
+}
 
-    // Read block
+bool BlockManager::ReadBlockCached(CBlock& block, const FlatFilePos& pos) const
+{
+    block.SetNull();
+
+    const auto block_data{ReadRawBlockCached(pos)};
+    if (!block_data) {
+        return false;
+    }
+    return DeserializeBlock(block, *block_data, pos, __func__);
+}
+
+bool BlockManager::ReadBlockCached(CBlock& block, const CBlockIndex& index) const
+{
+    return ReadIndexedBlock(block, index, /*use_serve_cache=*/true, __func__);
+}
+
+bool BlockManager::DeserializeBlock(CBlock& block, std::span<const uint8_t> block_data, const FlatFilePos& pos, const char* caller) const
+{
     try {
-        filein >> TX_WITH_WITNESS(block);
+        SpanReader{block_data} >> TX_WITH_WITNESS(block);
     } catch (const std::exception& e) {
-        LogError("%s: Deserialize or I/O error - %s at %s\n", __func__, e.what(), pos.ToString());
+        LogError("%s: Deserialize or I/O error - %s at %s\n", caller, e.what(), pos.ToString());
         return false;
     }
 
     // Check the header
     if (!CheckProofOfWork(block.GetHash(), block.nBits, GetConsensus())) {
-        LogError("%s: Errors in block header at %s\n", __func__, pos.ToString());
+        LogError("%s: Errors in block header at %s\n", caller, pos.ToString());
         return false;
     }
 
     // Signet only: check block solution
     if (GetConsensus().signet_blocks && !CheckSignetBlockSolution(block, GetConsensus())) {
-        LogError("%s: Errors in block solution at %s\n", __func__, pos.ToString());
+        LogError("%s: Errors in block solution at %s\n", caller, pos.ToString());
         return false;
     }
 
@@ -1031,14 +1089,19 @@ bool BlockManager::ReadBlock(CBlock& block, const FlatFilePos& pos) const
 }
 
 bool BlockManager::ReadBlock(CBlock& block, const CBlockIndex& index) const
+{
+    return ReadIndexedBlock(block, index, /*use_serve_cache=*/false, __func__);
+}
+
+bool BlockManager::ReadIndexedBlock(CBlock& block, const CBlockIndex& index, bool use_serve_cache, const char* caller) const
 {
     const FlatFilePos block_pos{WITH_LOCK(cs_main, return index.GetBlockPos())};
 
-    if (!ReadBlock(block, block_pos)) {
+    if (!(use_serve_cache ? ReadBlockCached(block, block_pos) : ReadBlock(block, block_pos))) {
         return false;
     }
     if (block.GetHash() != index.GetBlockHash()) {
-        LogError("%s: GetHash() doesn't match index for %s at %s\n", __func__, index.ToString(), block_pos.ToString());
+        LogError("%s: GetHash() doesn't match index for %s at %s\n", caller, index.ToString(), block_pos.ToString());
         return false;
     }
     return true;
@@ -1089,6 +1152,89 @@ bool BlockManager::ReadRawBlock(std::vector<uint8_t>& block, const FlatFilePos&
     return true;
 }
 
+BlockDataCache::Data BlockManager::ReadRawBlockCached(const FlatFilePos& pos) const
+{
+    if (auto block_data{m_serve_cache.Get(pos)}) return block_data;
+
+    const uint64_t erase_count{m_serve_cache.GetEraseCount()};
+    auto block_data{std::make_shared<std::vector<uint8_t>>()};
+    if (!ReadRawBlock(*block_data, pos)) {
+        return nullptr;
+    }
+    m_serve_cache.Put(pos, block_data, erase_count);
+    return block_data;
+}
+
+size_t BlockDataCache::Usage(const Entry& entry)
+{
+    // The list and map nodes are small compared to a block, and not counted.
+    return memusage::DynamicUsage(entry.data) + memusage::DynamicUsage(*entry.data);
+}
+
+BlockDataCache::Data BlockDataCache::Get(const FlatFilePos& pos)
+{
+    if (m_max_usage == 0) return nullptr;
+    LOCK(m_mutex);
+    const auto it{m_index.find(MakeKey(pos))};
+    if (it == m_index.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->data;
+}
+
+void BlockDataCache::Put(const FlatFilePos& pos, Data data, uint64_t erase_count)
+{
+    Entry entry{pos, std::move(data)};
+    const size_t usage{Usage(entry)};
+    if (usage > m_max_usage) return;
+    LOCK(m_mutex);
+    // Files may have been pruned while the block was read.
+    if (erase_count != m_erase_count) return;
+    // Another thread may have read the same block in the meantime.
+    if (m_index.contains(MakeKey(pos))) return;
+    while (!m_entries.empty() && m_usage + usage > m_max_usage) {
+        Erase(std::prev(m_entries.end()));
+    }
+    m_entries.push_front(std::move(entry));
+    m_index.emplace(MakeKey(pos), m_entries.begin());
+    m_usage += usage;
+}
+
+void BlockDataCache::EraseFiles(const std::set<int>& files)
+{
+    LOCK(m_mutex);
+    ++m_erase_count;
+    for (auto it{m_entries.begin()}; it != m_entries.end();) {
+        if (files.contains(it->pos.nFile)) {
+            Erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BlockDataCache::Erase(std::list<Entry>::iterator it)
+{
+    m_usage -= Usage(*it);
+    m_index.erase(MakeKey(it->pos));
+    m_entries.erase(it);
+}
+
+uint64_t BlockDataCache::GetEraseCount() const
+{
+    LOCK(m_mutex);
+    return m_erase_count;
+}
+
+BlockDataCache::Stats BlockDataCache::GetStats() const
+{
+    LOCK(m_mutex);
+    return {.entries = m_entries.size(), .usage = m_usage, .hits = m_hits, .misses = m_misses};
+}
+
 FlatFilePos BlockManager::WriteBlock(const CBlock& block, int nHeight)
 {
     const unsigned int block_size{static_cast<unsigned int>(GetSerializeSize(TX_WITH_WITNESS(block)))};
@@ -1170,6 +1316,7 @@ BlockManager::BlockManager(const util::SignalInterrupt& interrupt, Options opts)
       m_opts{std::move(opts)},
       m_block_file_seq{FlatFileSeq{m_opts.blocks_dir, "blk", m_opts.fast_prune ? 0x4000 /* 16kB */ : BLOCKFILE_CHUNK_SIZE}},
       m_undo_file_seq{FlatFileSeq{m_opts.blocks_dir, "rev", UNDOFILE_CHUNK_SIZE}},
+      m_serve_cache{m_opts.serve_cache_bytes},
       m_interrupt{interrupt}
 {
     m_block_tree_db = std::make_unique<BlockTreeDB>(m_opts.block_tree_db_params);
@@ -1201,33 +1348,221 @@ public:
     }
 };
 
+std::vector<ReindexBlock> ReadBlockFile(AutoFile& file, int file_num, const MessageStartChars& message_start, const util::SignalInterrupt& interrupt)
+{
+    std::vector<ReindexBlock> blocks;
+    BufferedFile blkdat{file, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8};
+    // nRewind indicates where to resume scanning in case something goes wrong,
+    // such as a block fails to deserialize.
+    uint64_t nRewind = blkdat.GetPos();
+    while (!blkdat.eof()) {
+        if (interrupt) break;
+
+        blkdat.SetPos(nRewind);
+        nRewind++; // start one byte further next time, in case of failure
+        blkdat.SetLimit(); // remove former limit
+        unsigned int nSize = 0;
+        try {
+            // locate a header
+            MessageStartChars buf;
+            blkdat.FindByte(std::byte(message_start[0]));
+            nRewind = blkdat.GetPos() + 1;
+            blkdat >> buf;
+            if (buf != message_start) {
+                continue;
+            }
+            // read size
+            blkdat >> nSize;
+            if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                continue;
+        } catch (const std::exception&) {
+            // no valid block header found; don't complain
+            // (this happens at the end of every blk.dat file)
+            break;
+        }
+        try {
+            const uint64_t nBlockPos{blkdat.GetPos()};
+            blkdat.SetLimit(nBlockPos + nSize);
+            auto pblock{std::make_shared<CBlock>()};
+            blkdat >> TX_WITH_WITNESS(*pblock);
+            nRewind = blkdat.GetPos();
+            blocks.push_back({std::move(pblock), FlatFilePos{file_num, static_cast<unsigned int>(nBlockPos)}});
+        } catch (const std::exception& e) {
+            // Historical bugs added extra data to the block files that does not deserialize cleanly.
+            // Such data is not fatal to the import process; keep scanning for the next block after it.
+            LogDebug(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", __func__, (nRewind - 1), e.what());
+        }
+    }
+    return blocks;
+}
+
+void BlockReorderBuffer::Add(ReindexBlock child)
+{
+    const uint256 parent_hash{child.block->hashPrevBlock};
+    size_t usage{RecursiveDynamicUsage(*child.block)};
+    if (m_usage + usage > m_max_usage) {
+        // Only keep the position; the block is read from disk again when needed.
+        child.block.reset();
+        usage = 0;
+    }
+    m_usage += usage;
+    m_children.emplace(parent_hash, Entry{std::move(child), usage});
+}
+
+std::vector<ReindexBlock> BlockReorderBuffer::Take(const uint256& parent_hash)
+{
+    std::vector<ReindexBlock> children;
+    const auto [begin, end]{m_children.equal_range(parent_hash)};
+    for (auto it{begin}; it != end; ++it) {
+        m_usage -= it->second.usage;
+        children.push_back(std::move(it->second.child));
+    }
+    m_children.erase(begin, end);
+    return children;
+}
+
+/**
+ * Block files read by the -reindex read threads, handed to the loading thread
+ * in file order. Threads do not start reading a file more than max_ahead files
+ * ahead of the one being loaded, which bounds the number of files whose blocks
+ * are held in memory.
+ */
+class ReindexFileQueue
+{
+public:
+    struct File {
+        std::vector<ReindexBlock> blocks;
+        //! Set if the file could not be read.
+        std::optional<std::string> error;
+    };
+
+private:
+    const int m_max_ahead;
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Files that were read, and not taken by the loading thread yet.
+    std::map<int, File> m_read GUARDED_BY(m_mutex);
+    int m_next_read GUARDED_BY(m_mutex){0};
+    int m_next_load GUARDED_BY(m_mutex){0};
+    //! The first file number that does not exist.
+    int m_end GUARDED_BY(m_mutex){std::numeric_limits<int>::max()};
+    bool m_stop GUARDED_BY(m_mutex){false};
+
+public:
+    explicit ReindexFileQueue(int max_ahead) : m_max_ahead{max_ahead} {}
+
+    /** Wait for a file to read. Returns std::nullopt once there are none left. */
+    std::optional<int> NextToRead() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_stop || m_next_read >= m_end || m_next_read < m_next_load + m_max_ahead;
+        });
+        if (m_stop || m_next_read >= m_end) return std::nullopt;
+        return m_next_read++;
+    }
+
+    /** Hand over a file that was read, or mark it as missing, which ends the queue. */
+    void Done(int file_num, std::optional<File> file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            LOCK(m_mutex);
+            if (file) {
+                m_read.emplace(file_num, std::move(*file));
+            } else {
+                m_end = std::min(m_end, file_num);
+            }
+        }
+        m_cv.notify_all();
+    }
+
+    /** Wait for the next file in order. Returns std::nullopt once there are none left. */
+    std::optional<File> NextToLoad() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::optional<File> file;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                return m_stop || m_next_load >= m_end || m_read.contains(m_next_load);
+            });
+            if (m_stop || m_next_load >= m_end) return std::nullopt;
+            file = std::move(m_read.extract(m_next_load++).mapped());
+        }
+        m_cv.notify_all();
+        return file;
+    }
+
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WITH_LOCK(m_mutex, m_stop = true);
+        m_cv.notify_all();
+    }
+};
+
+/** Read block files for -reindex, and check the blocks in them, until the queue ends. */
+static void ReadBlockFiles(ChainstateManager& chainman, ReindexFileQueue& queue)
+{
+    const CChainParams& params{chainman.GetParams()};
+    while (const auto file_num{queue.NextToRead()}) {
+        const FlatFilePos pos{*file_num, 0};
+        if (!fs::exists(chainman.m_blockman.GetBlockPosFilename(pos))) {
+            queue.Done(*file_num, std::nullopt); // No block files left to reindex
+            continue;
+        }
+        AutoFile file{chainman.m_blockman.OpenBlockFile(pos, true)};
+        if (file.IsNull()) {
+            queue.Done(*file_num, std::nullopt); // This error is logged in OpenBlockFile
+            continue;
+        }
+        ReindexFileQueue::File result;
+        try {
+            result.blocks = ReadBlockFile(file, *file_num, params.MessageStart(), chainman.m_interrupt);
+        } catch (const std::runtime_error& e) {
+            result.error = e.what();
+        }
+        // Run the context-free checks, including the merkle root, on this
+        // thread. CheckBlock() caches a successful result in the block, so
+        // AcceptBlock() does not repeat it on the loading thread.
+        for (const auto& [block, block_pos] : result.blocks) {
+            BlockValidationState state;
+            CheckBlock(*block, state, params.GetConsensus());
+        }
+        queue.Done(*file_num, std::move(result));
+    }
+}
+
 void ImportBlocks(ChainstateManager& chainman, std::span<const fs::path> import_paths)
 {
     ImportingNow imp{chainman.m_blockman.m_importing};
 
     // -reindex
     if (!chainman.m_blockman.m_blockfiles_indexed) {
-        int nFile = 0;
-        // Map of disk positions for blocks with unknown parent (only used for reindex);
-        // parent hash -> child disk position, multiple children can have the same parent.
-        std::multimap<uint256, FlatFilePos> blocks_with_unknown_parent;
-        while (true) {
-            FlatFilePos pos(nFile, 0);
-            if (!fs::exists(chainman.m_blockman.GetBlockPosFilename(pos))) {
-                break; // No block files left to reindex
-            }
-            AutoFile file{chainman.m_blockman.OpenBlockFile(pos, true)};
-            if (file.IsNull()) {
-                break; // This error is logged in OpenBlockFile
+        // Block files are read and checked on separate threads, while the
+        // blocks of the files read before are accepted in order on this one.
+        ReindexFileQueue queue{REINDEX_READ_THREADS};
+        std::vector<std::thread> read_threads;
+        for (int i = 0; i < REINDEX_READ_THREADS; ++i) {
+            read_threads.emplace_back(&util::TraceThread, strprintf("reindex.%i", i), [&] { ReadBlockFiles(chainman, queue); });
+        }
+        BlockReorderBuffer blocks_with_unknown_parent{REINDEX_REORDER_BUFFER_SIZE};
+        bool complete{true};
+        for (int nFile = 0; const auto file{queue.NextToLoad()}; ++nFile) {
+            if (file->error) {
+                chainman.GetNotifications().fatalError(strprintf(_("System error while loading external block file: %s"), *file->error));
+                complete = false;
+                break;
             }
             LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-            chainman.LoadExternalBlockFile(file, &pos, &blocks_with_unknown_parent);
+            chainman.LoadReindexBlocks(file->blocks, blocks_with_unknown_parent);
             if (chainman.m_interrupt) {
                 LogPrintf("Interrupt requested. Exit %s\n", __func__);
-                return;
+                complete = false;
+                break;
             }
-            nFile++;
         }
+        queue.Stop();
+        for (auto& thread : read_threads) thread.join();
+        if (!complete) return;
         WITH_LOCK(::cs_main, chainman.m_blockman.m_block_tree_db->WriteReindexing(false));
         chainman.m_blockman.m_blockfiles_indexed = true;
         LogPrintf("Reindexing finished\n");
@@ -25,6 +25,7 @@
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <list>
 #include <map>
 #include <memory>
 #include <optional>
@@ -74,6 +75,11 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 /** The maximum size of a blk?????.dat file (since 0.8) */
 static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 
+/** Number of threads reading block files ahead of the one being loaded during -reindex */
+static constexpr int REINDEX_READ_THREADS{2};
+/** Memory usage limit for out-of-order blocks kept in memory during -reindex */
+static constexpr size_t REINDEX_REORDER_BUFFER_SIZE{64 << 20}; // 64 MiB
+
 /** Size of header written by WriteBlock before a serialized CBlock (8 bytes) */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE{std::tuple_size_v<MessageStartChars> + sizeof(unsigned int)};
 
@@ -127,6 +133,59 @@ struct BlockfileCursor {
 
 std::ostream& operator<<(std::ostream& os, const BlockfileCursor& cursor);
 
+/**
+ * Memory-bounded LRU cache of serialized blocks, keyed by their position on
+ * disk. Peers syncing from us in parallel, and RPC or REST clients, tend to
+ * request the same blocks again, which this avoids reading from disk every
+ * time.
+ */
+class BlockDataCache
+{
+public:
+    using Data = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats {
+        size_t entries{0};
+        size_t usage{0};
+        uint64_t hits{0};
+        uint64_t misses{0};
+    };
+
+    explicit BlockDataCache(size_t max_usage) : m_max_usage{max_usage} {}
+
+    /** Return the block at pos and mark it as recently used, or nullptr if it is not cached. */
+    Data Get(const FlatFilePos& pos) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Add the block at pos, evicting the least recently used blocks to stay within the limit. erase_count
+     *  is the GetEraseCount() result from before the block was read. If EraseFiles was called since, the
+     *  block is not added, as it may have been read from a file that is being pruned. */
+    void Put(const FlatFilePos& pos, Data data, uint64_t erase_count) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Drop all blocks of the given block files, e.g. because they are pruned. */
+    void EraseFiles(const std::set<int>& files) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Return the number of EraseFiles calls so far. */
+    uint64_t GetEraseCount() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    Stats GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Entry {
+        FlatFilePos pos;
+        Data data;
+    };
+    using Key = uint64_t;
+    static Key MakeKey(const FlatFilePos& pos) { return (Key{uint32_t(pos.nFile)} << 32) | pos.nPos; }
+    static size_t Usage(const Entry& entry);
+    void Erase(std::list<Entry>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    const size_t m_max_usage;
+    mutable Mutex m_mutex;
+    //! Most recently used first.
+    std::list<Entry> m_entries GUARDED_BY(m_mutex);
+    std::unordered_map<Key, std::list<Entry>::iterator> m_index GUARDED_BY(m_mutex);
+    size_t m_usage GUARDED_BY(m_mutex){0};
+    uint64_t m_hits GUARDED_BY(m_mutex){0};
+    uint64_t m_misses GUARDED_BY(m_mutex){0};
+    uint64_t m_erase_count GUARDED_BY(m_mutex){0};
+};
+
 
 /**
  * Maintains a tree of blocks (stored in `m_block_index`) which is consulted
@@ -258,6 +317,16 @@ private:
     const FlatFileSeq m_block_file_seq;
     const FlatFileSeq m_undo_file_seq;
 
+    //! Recently served blocks, see ReadRawBlockCached()
+    mutable BlockDataCache m_serve_cache;
+
+    /** Deserialize the block read from pos, and check its proof of work. Errors are logged with the caller's name. */
+    bool DeserializeBlock(CBlock& block, std::span<const uint8_t> block_data, const FlatFilePos& pos, const char* caller) const;
+
+    /** Read the block of index, with or without the serve cache, and check that its hash matches. Errors are
+     *  logged with the caller's name. */
+    bool ReadIndexedBlock(CBlock& block, const CBlockIndex& index, bool use_serve_cache, const char* caller) const;
+
 public:
     using Options = kernel::BlockManagerOpts;
 
@@ -292,6 +361,14 @@ public:
 
     std::vector<CBlockIndex*> GetAllBlockIndices() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    /**
+     * All block indices, ordered by height (ties in unspecified order).
+     * Equivalent to sorting GetAllBlockIndices() with
+     * CBlockIndexHeightOnlyComparator, but linear in the size of the block
+     * index when heights are contiguous, which they are in a valid index.
+     */
+    std::vector<CBlockIndex*> GetAllBlockIndicesByHeight() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     /**
      * All pairs A->B, where A (or one of its ancestors) misses transactions, but B has transactions.
      * Pruned nodes may have entries where B is missing data.
@@ -418,11 +495,72 @@ public:
     bool ReadBlock(CBlock& block, const CBlockIndex& index) const;
     bool ReadRawBlock(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
 
+    /**
+     * Variants of ReadRawBlock() and ReadBlock() for serving blocks to peers
+     * and clients, which keep recently served blocks in memory (see
+     * -blockservecache). Validation should use the uncached ones, so that it
+     * does not evict the blocks being served.
+     */
+    BlockDataCache::Data ReadRawBlockCached(const FlatFilePos& pos) const;
+    bool ReadBlockCached(CBlock& block, const FlatFilePos& pos) const;
+    bool ReadBlockCached(CBlock& block, const CBlockIndex& index) const;
+
+    BlockDataCache::Stats GetServeCacheStats() const { return m_serve_cache.GetStats(); }
+
     bool ReadBlockUndo(CBlockUndo& blockundo, const CBlockIndex& index) const;
 
     void CleanupBlockRevFiles() const;
 };
 
+/** A block read from a block file during -reindex, and its position in the file. */
+struct ReindexBlock {
+    std::shared_ptr<const CBlock> block;
+    FlatFilePos pos;
+};
+
+/**
+ * Read all blocks in a block file, in the order they are stored. Data that
+ * does not deserialize as a block is skipped, as historical bugs left some in
+ * block files. Returns the blocks read so far if interrupted.
+ *
+ * @throws std::runtime_error if the file cannot be read.
+ */
+std::vector<ReindexBlock> ReadBlockFile(AutoFile& file, int file_num, const MessageStartChars& message_start, const util::SignalInterrupt& interrupt);
+
+/**
+ * Blocks read during -reindex whose parent has not been accepted yet, by
+ * parent hash. Blocks are kept in memory up to a memory usage limit. Beyond
+ * it, only their position is kept, and they have to be read from disk again
+ * once their parent is accepted.
+ */
+class BlockReorderBuffer
+{
+    struct Entry {
+        ReindexBlock child;
+        size_t usage;
+    };
+
+    const size_t m_max_usage;
+    size_t m_usage{0};
+    //! Parent hash -> child. A multimap, as several blocks may have the same parent.
+    std::multimap<uint256, Entry> m_children;
+
+public:
+    explicit BlockReorderBuffer(size_t max_usage) : m_max_usage{max_usage} {}
+
+    /** Add a block whose parent is not known yet. */
+    void Add(ReindexBlock child);
+
+    /**
+     * Remove and return the children of a block, in the order they were
+     * added. Children that did not fit in memory have a null block.
+     */
+    std::vector<ReindexBlock> Take(const uint256& parent_hash);
+
+    size_t Size() const { return m_children.size(); }
+    size_t DynamicMemoryUsage() const { return m_usage; }
+};
+
 // Calls ActivateBestChain() even if no blocks are imported.
 void ImportBlocks(ChainstateManager& chainman, std::span<const fs::path> import_paths);
 } // namespace node
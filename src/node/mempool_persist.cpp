@@ -38,6 +38,17 @@ namespace node {
 static const uint64_t MEMPOOL_DUMP_VERSION_NO_XOR_KEY{1};
 static const uint64_t MEMPOOL_DUMP_VERSION{2};
 
+namespace {
+//! Number of mempool.dat entries whose signatures are checked together.
+constexpr size_t LOAD_BATCH_SIZE{1000};
+
+struct LoadedTx {
+    CTransactionRef tx;
+    int64_t nTime;
+    int64_t nFeeDelta;
+};
+} // namespace
+
 bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active_chainstate, ImportMempoolOptions&& opts)
 {
     if (load_path.empty()) return false;
@@ -72,51 +83,74 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
         uint64_t txns_tried = 0;
         LogInfo("Loading %u mempool transactions from file...\n", total_txns_to_load);
         int next_tenth_to_report = 0;
+        const int64_t expiry_cutoff{TicksSinceEpoch<std::chrono::seconds>(now - pool.m_opts.expiry)};
+        std::vector<LoadedTx> batch;
         while (txns_tried < total_txns_to_load) {
-            const int percentage_done(100.0 * txns_tried / total_txns_to_load);
-            if (next_tenth_to_report < percentage_done / 10) {
-                LogInfo("Progress loading mempool transactions from file: %d%% (tried %u, %u remaining)\n",
-                        percentage_done, txns_tried, total_txns_to_load - txns_tried);
-                next_tenth_to_report = percentage_done / 10;
+            // Read the next batch, and check its signatures in parallel before
+            // submitting the transactions one by one. If reading fails halfway,
+            // the complete entries read so far are still submitted before the
+            // error is passed on.
+            batch.clear();
+            std::exception_ptr read_error;
+            try {
+                while (txns_tried + batch.size() < total_txns_to_load && batch.size() < LOAD_BATCH_SIZE) {
+                    LoadedTx loaded;
+                    file >> TX_WITH_WITNESS(loaded.tx);
+                    file >> loaded.nTime;
+                    file >> loaded.nFeeDelta;
+                    if (opts.use_current_time) {
+                        loaded.nTime = TicksSinceEpoch<std::chrono::seconds>(now);
+                    }
+                    batch.push_back(std::move(loaded));
+                }
+            } catch (const std::exception&) {
+                read_error = std::current_exception();
             }
-            ++txns_tried;
-
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> TX_WITH_WITNESS(tx);
-            file >> nTime;
-            file >> nFeeDelta;
-
-            if (opts.use_current_time) {
-                nTime = TicksSinceEpoch<std::chrono::seconds>(now);
+            std::vector<CTransactionRef> unexpired;
+            unexpired.reserve(batch.size());
+            for (const auto& loaded : batch) {
+                if (loaded.nTime > expiry_cutoff) unexpired.push_back(loaded.tx);
             }
+            // Transactions are dumped in topological order, so parents from
+            // the same batch come before their children.
+            WITH_LOCK(cs_main, PrewarmSignatureCache(active_chainstate, pool, unexpired));
+
+            for (const auto& [tx, nTime, nFeeDelta] : batch) {
+                const int percentage_done(100.0 * txns_tried / total_txns_to_load);
+                if (next_tenth_to_report < percentage_done / 10) {
+                    LogInfo("Progress loading mempool transactions from file: %d%% (tried %u, %u remaining)\n",
+                            percentage_done, txns_tried, total_txns_to_load - txns_tried);
+                    next_tenth_to_report = percentage_done / 10;
+                }
+                ++txns_tried;
 
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta && opts.apply_fee_delta_priority) {
-                pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
-            }
-            if (nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_opts.expiry)) {
-                LOCK(cs_main);
-                const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, nTime, /*bypass_limits=*/false, /*test_accept=*/false);
-                if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
-                    ++count;
-                } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (pool.exists(GenTxid::Txid(tx->GetHash()))) {
-                        ++already_there;
+                CAmount amountdelta = nFeeDelta;
+                if (amountdelta && opts.apply_fee_delta_priority) {
+                    pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+                }
+                if (nTime > expiry_cutoff) {
+                    LOCK(cs_main);
+                    const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, nTime, /*bypass_limits=*/false, /*test_accept=*/false, /*scripts_prewarmed=*/true);
+                    if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+                        ++count;
                     } else {
-                        ++failed;
+                        // mempool may contain the transaction already, e.g. from
+                        // wallet(s) having loaded it while we were processing
+                        // mempool transactions; consider these as valid, instead of
+                        // failed, but mark them as 'already there'
+                        if (pool.exists(GenTxid::Txid(tx->GetHash()))) {
+                            ++already_there;
+                        } else {
+                            ++failed;
+                        }
                     }
+                } else {
+                    ++expired;
                 }
-            } else {
-                ++expired;
+                if (active_chainstate.m_chainman.m_interrupt)
+                    return false;
             }
-            if (active_chainstate.m_chainman.m_interrupt)
-                return false;
+            if (read_error) std::rethrow_exception(read_error);
         }
         std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
@@ -20,11 +20,14 @@
 #include <policy/policy.h>
 #include <pow.h>
 #include <primitives/transaction.h>
+#include <util/hasher.h>
 #include <util/moneystr.h>
 #include <util/time.h>
 #include <validation.h>
 
 #include <algorithm>
+#include <map>
+#include <unordered_set>
 #include <utility>
 
 namespace node {
@@ -254,6 +257,16 @@ static int UpdatePackagesForAdded(const CTxMemPool& mempool,
 {
     AssertLockHeld(mempool.cs);
 
+    // Ancestor state removed from each descendant. Summing this up first means
+    // every descendant is only re-sorted in mapModifiedTx once per package,
+    // rather than once for each of its ancestors in the package.
+    struct RemovedAncestorState {
+        uint64_t size{0};
+        CAmount fees{0};
+        int64_t sigops{0};
+    };
+    std::map<CTxMemPool::txiter, RemovedAncestorState, CompareCTxMemPoolIter> updates;
+
     int nDescendantsUpdated = 0;
     for (CTxMemPool::txiter it : alreadyAdded) {
         CTxMemPool::setEntries descendants;
@@ -264,12 +277,25 @@ static int UpdatePackagesForAdded(const CTxMemPool& mempool,
                 continue;
             }
             ++nDescendantsUpdated;
-            modtxiter mit = mapModifiedTx.find(desc);
-            if (mit == mapModifiedTx.end()) {
-                CTxMemPoolModifiedEntry modEntry(desc);
-                mit = mapModifiedTx.insert(modEntry).first;
-            }
-            mapModifiedTx.modify(mit, update_for_parent_inclusion(it));
+            RemovedAncestorState& removed{updates[desc]};
+            removed.size += it->GetTxSize();
+            removed.fees += it->GetModifiedFee();
+            removed.sigops += it->GetSigOpCost();
+        }
+    }
+    for (const auto& [desc, removed] : updates) {
+        const auto apply{[&removed](CTxMemPoolModifiedEntry& e) {
+            e.nModFeesWithAncestors -= removed.fees;
+            e.nSizeWithAncestors -= removed.size;
+            e.nSigOpCostWithAncestors -= removed.sigops;
+        }};
+        modtxiter mit = mapModifiedTx.find(desc);
+        if (mit == mapModifiedTx.end()) {
+            CTxMemPoolModifiedEntry modEntry(desc);
+            apply(modEntry);
+            mapModifiedTx.insert(modEntry);
+        } else {
+            mapModifiedTx.modify(mit, apply);
         }
     }
     return nDescendantsUpdated;
@@ -305,7 +331,7 @@ void BlockAssembler::addPackageTxs(int& nPackagesSelected, int& nDescendantsUpda
     // because some of their txs are already in the block
     indexed_modified_transaction_set mapModifiedTx;
     // Keep track of entries that failed inclusion, to avoid duplicate work
-    std::set<Txid> failedTx;
+    std::unordered_set<Txid, SaltedTxidHasher> failedTx;
 
     CTxMemPool::indexed_transaction_set::index<ancestor_score>::type::iterator mi = mempool.mapTx.get<ancestor_score>().begin();
     CTxMemPool::txiter iter;
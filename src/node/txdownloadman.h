@@ -13,6 +13,7 @@
 #include <memory>
 
 class CBlock;
+class ChainstateManager;
 class CRollingBloomFilter;
 class CTxMemPool;
 class GenTxid;
@@ -45,6 +46,9 @@ struct TxDownloadOptions {
     const uint32_t m_max_orphan_txs;
     /** Instantiate TxRequestTracker as deterministic (used for tests). */
     bool m_deterministic_txrequest{false};
+    /** Read-only pointer to the chainstate manager, used to tell confirmed parents of an orphan apart
+     *  from missing ones. If null, orphans are reconsidered whenever any of their parents arrives. */
+    const ChainstateManager* m_chainman{nullptr};
 };
 struct TxDownloadConnectionInfo {
     /** Whether this peer is preferred for transaction download. */
@@ -333,7 +333,9 @@ void TxDownloadManagerImpl::MempoolAcceptedTx(const CTransactionRef& tx)
     m_txrequest.ForgetTxHash(tx->GetHash());
     m_txrequest.ForgetTxHash(tx->GetWitnessHash());
 
-    m_orphanage.AddChildrenToWorkSet(*tx, m_opts.m_rng);
+    m_orphanage.AddChildrenToWorkSet(*tx, m_opts.m_rng, [&](const Txid& parent_txid) {
+        return m_opts.m_mempool.exists(GenTxid::Txid(parent_txid));
+    });
     // If it came from the orphanage, remove it. No-op if the tx is not in txorphanage.
     m_orphanage.EraseTx(tx->GetWitnessHash());
 }
@@ -353,6 +355,29 @@ std::vector<Txid> TxDownloadManagerImpl::GetUniqueParents(const CTransaction& tx
     return unique_parents;
 }
 
+std::vector<Txid> TxDownloadManagerImpl::GetMissingParents(const CTransaction& tx, std::span<const Txid> parents)
+{
+    // Parents confirmed before the recent confirmed filter covers are not found by AlreadyHaveTx. Without
+    // a view of the UTXO set, they could not be told apart from missing parents that will arrive later.
+    if (!m_opts.m_chainman) return {};
+
+    LOCK(::cs_main);
+    CCoinsViewCache& coins_tip{m_opts.m_chainman->ActiveChainstate().CoinsTip()};
+    std::vector<Txid> missing_parents;
+    for (const Txid& parent_txid : parents) {
+        const bool confirmed{std::ranges::any_of(tx.vin, [&](const CTxIn& txin) {
+            if (txin.prevout.hash != parent_txid) return false;
+            // Do not leave coins of arbitrary orphans in the cache.
+            const bool in_cache{coins_tip.HaveCoinInCache(txin.prevout)};
+            const bool have_coin{coins_tip.HaveCoin(txin.prevout)};
+            if (!in_cache) coins_tip.Uncache(txin.prevout);
+            return have_coin;
+        })};
+        if (!confirmed) missing_parents.push_back(parent_txid);
+    }
+    return missing_parents;
+}
+
 node::RejectedTxTodo TxDownloadManagerImpl::MempoolRejectedTx(const CTransactionRef& ptx, const TxValidationState& state, NodeId nodeid, bool first_time_failure)
 {
     const CTransaction& tx{*ptx};
@@ -415,9 +440,11 @@ node::RejectedTxTodo TxDownloadManagerImpl::MempoolRejectedTx(const CTransaction
                 m_txrequest.GetCandidatePeers(ptx->GetHash().ToUint256(), orphan_resolution_candidates);
                 if (ptx->HasWitness()) m_txrequest.GetCandidatePeers(ptx->GetWitnessHash().ToUint256(), orphan_resolution_candidates);
 
+                // Only the parents that are neither in the mempool nor confirmed are waiting to arrive.
+                const std::vector<Txid> missing_parents{GetMissingParents(tx, unique_parents)};
                 for (const auto& nodeid : orphan_resolution_candidates) {
                     if (MaybeAddOrphanResolutionCandidate(unique_parents, ptx->GetWitnessHash(), nodeid, now)) {
-                        m_orphanage.AddTx(ptx, nodeid);
+                        m_orphanage.AddTx(ptx, nodeid, missing_parents);
                     }
                 }
 
@@ -194,6 +194,10 @@ protected:
     /** Helper for getting deduplicated vector of Txids in vin. */
     std::vector<Txid> GetUniqueParents(const CTransaction& tx);
 
+    /** Helper for getting the parents, out of the given ones, that have no confirmed output spent by tx.
+     *  Returns an empty vector (no parents known to be missing) if m_opts.m_chainman is not set. */
+    std::vector<Txid> GetMissingParents(const CTransaction& tx, std::span<const Txid> parents);
+
     /** If this peer is an orphan resolution candidate for this transaction, treat the unique_parents as announced by
      * this peer; add them as new invs to m_txrequest.
      * @returns whether this transaction was a valid orphan resolution candidate.
@@ -533,6 +533,7 @@ bool CBlockPolicyEstimator::_removeTx(const uint256& hash, bool inBlock)
         shortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         longStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         mapMemPoolTxs.erase(hash);
+        ++m_estimates_generation;
         return true;
     } else {
         return false;
@@ -682,6 +683,7 @@ void CBlockPolicyEstimator::processBlock(const std::vector<RemovedMempoolTransac
     // calls to removeTx (via processBlockTx) correctly calculate age
     // of unconfirmed txs to remove from tracking.
     nBestSeenHeight = nBlockHeight;
+    ++m_estimates_generation;
 
     // Update unconfirmed circular buffer
     feeStats->ClearCurrent(nBlockHeight);
@@ -869,7 +871,30 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
  */
 CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
 {
+    const std::pair<int, bool> key{confTarget, conservative};
+    {
+        LOCK(m_cs_smart_fee_cache);
+        if (auto it{m_smart_fee_cache.find(key)}; it != m_smart_fee_cache.end() && it->second.generation == m_estimates_generation) {
+            if (feeCalc) *feeCalc = it->second.calc;
+            return it->second.feerate;
+        }
+    }
+
     LOCK(m_cs_fee_estimator);
+    FeeCalculation calc;
+    const CFeeRate feerate{estimateSmartFeeUncached(confTarget, &calc, conservative)};
+    if (feeCalc) *feeCalc = calc;
+    // Only cache targets we track, to bound the size of the cache.
+    if (confTarget > 0 && (unsigned int)confTarget <= longStats->GetMaxConfirms()) {
+        LOCK(m_cs_smart_fee_cache);
+        m_smart_fee_cache.insert_or_assign(key, CachedSmartFee{m_estimates_generation, feerate, calc});
+    }
+    return feerate;
+}
+
+CFeeRate CBlockPolicyEstimator::estimateSmartFeeUncached(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
 
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
@@ -1038,6 +1063,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            ++m_estimates_generation;
         }
     }
     catch (const std::exception& e) {
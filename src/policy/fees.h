@@ -15,11 +15,13 @@
 #include <validationinterface.h>
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -225,7 +227,7 @@ public:
      *  valid over longer time horizons also.
      */
     CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
-        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator, !m_cs_smart_fee_cache);
 
     /** Return a specific fee estimate calculation with a given success
      * threshold and time horizon, and optionally return detailed data about
@@ -300,9 +302,31 @@ private:
     std::vector<double> buckets GUARDED_BY(m_cs_fee_estimator); // The upper-bound of the range for the bucket (inclusive)
     std::map<double, unsigned int> bucketMap GUARDED_BY(m_cs_fee_estimator); // Map of bucket upper-bound to index into all vectors by bucket
 
+    /**
+     * Smart fee estimates only change when a block is processed or a tracked
+     * transaction leaves the mempool; a transaction entering the mempool is
+     * only counted as unconfirmed from the next block on. Results of
+     * estimateSmartFee are cached per (target, conservative) until then, so
+     * that repeated queries don't contend with mempool acceptance for
+     * m_cs_fee_estimator.
+     */
+    struct CachedSmartFee {
+        uint64_t generation;
+        CFeeRate feerate;
+        FeeCalculation calc;
+    };
+    //! Incremented (while holding m_cs_fee_estimator) whenever estimates may change.
+    std::atomic<uint64_t> m_estimates_generation{0};
+    //! Acquired after m_cs_fee_estimator when both are held.
+    mutable Mutex m_cs_smart_fee_cache;
+    mutable std::map<std::pair<int, bool>, CachedSmartFee> m_smart_fee_cache GUARDED_BY(m_cs_smart_fee_cache);
+
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const RemovedMempoolTransactionInfo& tx) EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
 
+    /** estimateSmartFee without the result cache */
+    CFeeRate estimateSmartFeeUncached(int confTarget, FeeCalculation *feeCalc, bool conservative) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+
     /** Helper for estimateSmartFee */
     double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
@@ -318,10 +318,11 @@ static bool rest_block(const std::any& context,
         pos = pblockindex->GetBlockPos();
     }
 
-    std::vector<uint8_t> block_data{};
-    if (!chainman.m_blockman.ReadRawBlock(block_data, pos)) {
+    const auto block_data_ptr{chainman.m_blockman.ReadRawBlockCached(pos)};
+    if (!block_data_ptr) {
         return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
+    const std::vector<uint8_t>& block_data{*block_data_ptr};
 
     switch (rf) {
     case RESTResponseFormat::BINARY: {
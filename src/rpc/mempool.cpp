@@ -10,6 +10,7 @@
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <index/txospenderindex.h>
 #include <kernel/mempool_entry.h>
 #include <net_processing.h>
 #include <node/mempool_persist_args.h>
@@ -27,8 +28,14 @@
 #include <util/strencodings.h>
 #include <util/time.h>
 #include <util/vector.h>
+#include <validation.h>
 
+#include <chrono>
+#include <optional>
+#include <set>
+#include <string>
 #include <utility>
+#include <vector>
 
 using node::DumpMempool;
 
@@ -284,33 +291,96 @@ static std::vector<RPCResult> MempoolEntryDescription()
     };
 }
 
-static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+namespace {
+/** The mempool data reported for one entry, copied out of the mempool so that
+ *  it can be turned into JSON without holding pool.cs. */
+struct MempoolEntrySnapshot {
+    CTransactionRef tx;
+    int32_t vsize;
+    int32_t weight;
+    std::chrono::seconds time;
+    unsigned int height;
+    uint64_t descendant_count;
+    int64_t descendant_size;
+    uint64_t ancestor_count;
+    int64_t ancestor_size;
+    CAmount fee;
+    CAmount modified_fee;
+    CAmount ancestor_fees;
+    CAmount descendant_fees;
+    std::vector<Txid> depends;
+    std::vector<Txid> spent_by;
+    bool bip125_replaceable;
+    bool unbroadcast;
+};
+} // namespace
+
+static MempoolEntrySnapshot SnapshotEntry(const CTxMemPool& pool, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
 {
     AssertLockHeld(pool.cs);
 
-    info.pushKV("vsize", (int)e.GetTxSize());
-    info.pushKV("weight", (int)e.GetTxWeight());
-    info.pushKV("time", count_seconds(e.GetTime()));
-    info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
-    info.pushKV("wtxid", e.GetTx().GetWitnessHash().ToString());
+    MempoolEntrySnapshot snapshot{
+        .tx = e.GetSharedTx(),
+        .vsize = e.GetTxSize(),
+        .weight = e.GetTxWeight(),
+        .time = e.GetTime(),
+        .height = e.GetHeight(),
+        .descendant_count = e.GetCountWithDescendants(),
+        .descendant_size = e.GetSizeWithDescendants(),
+        .ancestor_count = e.GetCountWithAncestors(),
+        .ancestor_size = e.GetSizeWithAncestors(),
+        .fee = e.GetFee(),
+        .modified_fee = e.GetModifiedFee(),
+        .ancestor_fees = e.GetModFeesWithAncestors(),
+        .descendant_fees = e.GetModFeesWithDescendants(),
+        .depends = {},
+        .spent_by = {},
+        .bip125_replaceable = false,
+        .unbroadcast = pool.IsUnbroadcastTx(e.GetTx().GetHash()),
+    };
+
+    const CTransaction& tx = e.GetTx();
+    for (const CTxIn& txin : tx.vin) {
+        if (pool.exists(GenTxid::Txid(txin.prevout.hash))) {
+            snapshot.depends.push_back(txin.prevout.hash);
+        }
+    }
+    for (const CTxMemPoolEntry& child : e.GetMemPoolChildrenConst()) {
+        snapshot.spent_by.push_back(child.GetTx().GetHash());
+    }
+
+    // Add opt-in RBF status
+    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
+    if (rbfState == RBFTransactionState::UNKNOWN) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
+    } else if (rbfState == RBFTransactionState::REPLACEABLE_BIP125) {
+        snapshot.bip125_replaceable = true;
+    }
+    return snapshot;
+}
+
+static void entryToJSON(UniValue& info, const MempoolEntrySnapshot& e)
+{
+    info.pushKV("vsize", e.vsize);
+    info.pushKV("weight", e.weight);
+    info.pushKV("time", count_seconds(e.time));
+    info.pushKV("height", (int)e.height);
+    info.pushKV("descendantcount", e.descendant_count);
+    info.pushKV("descendantsize", e.descendant_size);
+    info.pushKV("ancestorcount", e.ancestor_count);
+    info.pushKV("ancestorsize", e.ancestor_size);
+    info.pushKV("wtxid", e.tx->GetWitnessHash().ToString());
 
     UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", ValueFromAmount(e.GetFee()));
-    fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    fees.pushKV("base", ValueFromAmount(e.fee));
+    fees.pushKV("modified", ValueFromAmount(e.modified_fee));
+    fees.pushKV("ancestor", ValueFromAmount(e.ancestor_fees));
+    fees.pushKV("descendant", ValueFromAmount(e.descendant_fees));
     info.pushKV("fees", std::move(fees));
 
-    const CTransaction& tx = e.GetTx();
     std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
-    {
-        if (pool.exists(GenTxid::Txid(txin.prevout.hash)))
-            setDepends.insert(txin.prevout.hash.ToString());
+    for (const Txid& dep : e.depends) {
+        setDepends.insert(dep.ToString());
     }
 
     UniValue depends(UniValue::VARR);
@@ -322,23 +392,33 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("depends", std::move(depends));
 
     UniValue spent(UniValue::VARR);
-    for (const CTxMemPoolEntry& child : e.GetMemPoolChildrenConst()) {
-        spent.push_back(child.GetTx().GetHash().ToString());
+    for (const Txid& child : e.spent_by) {
+        spent.push_back(child.ToString());
     }
 
     info.pushKV("spentby", std::move(spent));
+    info.pushKV("bip125-replaceable", e.bip125_replaceable);
+    info.pushKV("unbroadcast", e.unbroadcast);
+}
 
-    // Add opt-in RBF status
-    bool rbfStatus = false;
-    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
-    if (rbfState == RBFTransactionState::UNKNOWN) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
-    } else if (rbfState == RBFTransactionState::REPLACEABLE_BIP125) {
-        rbfStatus = true;
+/** Build the result of getmempoolancestors or getmempooldescendants from entries copied under the lock. */
+static UniValue RelativesToJSON(bool verbose, const std::vector<Txid>& txids, const std::vector<MempoolEntrySnapshot>& entries)
+{
+    if (!verbose) {
+        UniValue o(UniValue::VARR);
+        for (const Txid& txid : txids) {
+            o.push_back(txid.ToString());
+        }
+        return o;
+    } else {
+        UniValue o(UniValue::VOBJ);
+        for (const MempoolEntrySnapshot& e : entries) {
+            UniValue info(UniValue::VOBJ);
+            entryToJSON(info, e);
+            o.pushKV(e.tx->GetHash().ToString(), std::move(info));
+        }
+        return o;
     }
-
-    info.pushKV("bip125-replaceable", rbfStatus);
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
 }
 
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
@@ -347,27 +427,41 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
         if (include_mempool_sequence) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbose results cannot contain mempool sequence values.");
         }
-        LOCK(pool.cs);
+        // Only copy the entries while holding the lock; building the JSON
+        // for a large mempool takes much longer and would stall acceptance.
+        std::vector<MempoolEntrySnapshot> entries;
+        {
+            LOCK(pool.cs);
+            entries.reserve(pool.size());
+            for (const CTxMemPoolEntry& e : pool.entryAll()) {
+                entries.push_back(SnapshotEntry(pool, e));
+            }
+        }
         UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry& e : pool.entryAll()) {
+        for (const MempoolEntrySnapshot& e : entries) {
             UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e);
+            entryToJSON(info, e);
             // Mempool has unique entries so there is no advantage in using
             // UniValue::pushKV, which checks if the key already exists in O(N).
             // UniValue::pushKVEnd is used instead which currently is O(1).
-            o.pushKVEnd(e.GetTx().GetHash().ToString(), std::move(info));
+            o.pushKVEnd(e.tx->GetHash().ToString(), std::move(info));
         }
         return o;
     } else {
-        UniValue a(UniValue::VARR);
+        std::vector<Txid> txids;
         uint64_t mempool_sequence;
         {
             LOCK(pool.cs);
+            txids.reserve(pool.size());
             for (const CTxMemPoolEntry& e : pool.entryAll()) {
-                a.push_back(e.GetTx().GetHash().ToString());
+                txids.push_back(e.GetTx().GetHash());
             }
             mempool_sequence = pool.GetSequence();
         }
+        UniValue a(UniValue::VARR);
+        for (const Txid& txid : txids) {
+            a.push_back(txid.ToString());
+        }
         if (!include_mempool_sequence) {
             return a;
         } else {
@@ -460,32 +554,27 @@ static RPCHelpMan getmempoolancestors()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
+    std::vector<Txid> txids;
+    std::vector<MempoolEntrySnapshot> entries;
+    {
+        LOCK(mempool.cs);
 
-    const auto entry{mempool.GetEntry(Txid::FromUint256(hash))};
-    if (entry == nullptr) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
+        const auto entry{mempool.GetEntry(Txid::FromUint256(hash))};
+        if (entry == nullptr) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
+        }
 
-    auto ancestors{mempool.AssumeCalculateMemPoolAncestors(self.m_name, *entry, CTxMemPool::Limits::NoLimits(), /*fSearchForParents=*/false)};
+        auto ancestors{mempool.AssumeCalculateMemPoolAncestors(self.m_name, *entry, CTxMemPool::Limits::NoLimits(), /*fSearchForParents=*/false)};
 
-    if (!fVerbose) {
-        UniValue o(UniValue::VARR);
-        for (CTxMemPool::txiter ancestorIt : ancestors) {
-            o.push_back(ancestorIt->GetTx().GetHash().ToString());
-        }
-        return o;
-    } else {
-        UniValue o(UniValue::VOBJ);
         for (CTxMemPool::txiter ancestorIt : ancestors) {
-            const CTxMemPoolEntry &e = *ancestorIt;
-            const uint256& _hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e);
-            o.pushKV(_hash.ToString(), std::move(info));
+            if (fVerbose) {
+                entries.push_back(SnapshotEntry(mempool, *ancestorIt));
+            } else {
+                txids.push_back(ancestorIt->GetTx().GetHash());
+            }
         }
-        return o;
     }
+    return RelativesToJSON(fVerbose, txids, entries);
 },
     };
 }
@@ -521,36 +610,30 @@ static RPCHelpMan getmempooldescendants()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
-
-    const auto it{mempool.GetIter(hash)};
-    if (!it) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
-
-    CTxMemPool::setEntries setDescendants;
-    mempool.CalculateDescendants(*it, setDescendants);
-    // CTxMemPool::CalculateDescendants will include the given tx
-    setDescendants.erase(*it);
+    std::vector<Txid> txids;
+    std::vector<MempoolEntrySnapshot> entries;
+    {
+        LOCK(mempool.cs);
 
-    if (!fVerbose) {
-        UniValue o(UniValue::VARR);
-        for (CTxMemPool::txiter descendantIt : setDescendants) {
-            o.push_back(descendantIt->GetTx().GetHash().ToString());
+        const auto it{mempool.GetIter(hash)};
+        if (!it) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
         }
 
-        return o;
-    } else {
-        UniValue o(UniValue::VOBJ);
+        CTxMemPool::setEntries setDescendants;
+        mempool.CalculateDescendants(*it, setDescendants);
+        // CTxMemPool::CalculateDescendants will include the given tx
+        setDescendants.erase(*it);
+
         for (CTxMemPool::txiter descendantIt : setDescendants) {
-            const CTxMemPoolEntry &e = *descendantIt;
-            const uint256& _hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e);
-            o.pushKV(_hash.ToString(), std::move(info));
+            if (fVerbose) {
+                entries.push_back(SnapshotEntry(mempool, *descendantIt));
+            } else {
+                txids.push_back(descendantIt->GetTx().GetHash());
+            }
         }
-        return o;
     }
+    return RelativesToJSON(fVerbose, txids, entries);
 },
     };
 }
@@ -573,15 +656,18 @@ static RPCHelpMan getmempoolentry()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
-
-    const auto entry{mempool.GetEntry(Txid::FromUint256(hash))};
-    if (entry == nullptr) {
+    const auto snapshot{[&]() -> std::optional<MempoolEntrySnapshot> {
+        LOCK(mempool.cs);
+        const auto entry{mempool.GetEntry(Txid::FromUint256(hash))};
+        if (entry == nullptr) return std::nullopt;
+        return SnapshotEntry(mempool, *entry);
+    }()};
+    if (!snapshot) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
     }
 
     UniValue info(UniValue::VOBJ);
-    entryToJSON(mempool, info, *entry);
+    entryToJSON(info, *snapshot);
     return info;
 },
     };
@@ -590,7 +676,7 @@ static RPCHelpMan getmempoolentry()
 static RPCHelpMan gettxspendingprevout()
 {
     return RPCHelpMan{"gettxspendingprevout",
-        "Scans the mempool to find transactions spending any of the given outputs",
+        "Scans the mempool, and the spent output index if enabled (-txospenderindex), to find transactions spending any of the given outputs",
         {
             {"outputs", RPCArg::Type::ARR, RPCArg::Optional::NO, "The transaction outputs that we want to check, and within each, the txid (string) vout (numeric).",
                 {
@@ -610,7 +696,8 @@ static RPCHelpMan gettxspendingprevout()
                 {
                     {RPCResult::Type::STR_HEX, "txid", "the transaction id of the checked output"},
                     {RPCResult::Type::NUM, "vout", "the vout value of the checked output"},
-                    {RPCResult::Type::STR_HEX, "spendingtxid", /*optional=*/true, "the transaction id of the mempool transaction spending this output (omitted if unspent)"},
+                    {RPCResult::Type::STR_HEX, "spendingtxid", /*optional=*/true, "the transaction id of the mempool or confirmed transaction spending this output (omitted if unspent, or if only spent in a block and -txospenderindex is disabled)"},
+                    {RPCResult::Type::STR_HEX, "blockhash", /*optional=*/true, "the hash of the block containing the spending transaction (only for confirmed spends)"},
                 }},
             }
         },
@@ -647,18 +734,37 @@ static RPCHelpMan gettxspendingprevout()
             }
 
             const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-            LOCK(mempool.cs);
+            std::vector<std::optional<Txid>> mempool_spenders;
+            mempool_spenders.reserve(prevouts.size());
+            {
+                LOCK(mempool.cs);
+                for (const COutPoint& prevout : prevouts) {
+                    const CTransaction* spendingTx = mempool.GetConflictTx(prevout);
+                    mempool_spenders.push_back(spendingTx ? std::optional{spendingTx->GetHash()} : std::nullopt);
+                }
+            }
 
-            UniValue result{UniValue::VARR};
+            // Outputs that are not spent in the mempool may have been spent in a block.
+            std::vector<std::optional<TxoSpenderIndex::Spender>> confirmed_spenders(prevouts.size());
+            if (g_txospenderindex) {
+                g_txospenderindex->BlockUntilSyncedToCurrentChain();
+                for (size_t i{0}; i < prevouts.size(); ++i) {
+                    if (!mempool_spenders[i]) confirmed_spenders[i] = g_txospenderindex->FindSpender(prevouts[i]);
+                }
+            }
 
-            for (const COutPoint& prevout : prevouts) {
+            UniValue result{UniValue::VARR};
+            for (size_t i{0}; i < prevouts.size(); ++i) {
+                const COutPoint& prevout{prevouts[i]};
                 UniValue o(UniValue::VOBJ);
                 o.pushKV("txid", prevout.hash.ToString());
                 o.pushKV("vout", (uint64_t)prevout.n);
 
-                const CTransaction* spendingTx = mempool.GetConflictTx(prevout);
-                if (spendingTx != nullptr) {
-                    o.pushKV("spendingtxid", spendingTx->GetHash().ToString());
+                if (mempool_spenders[i]) {
+                    o.pushKV("spendingtxid", mempool_spenders[i]->ToString());
+                } else if (const auto& spender{confirmed_spenders[i]}) {
+                    o.pushKV("spendingtxid", spender->txid.ToString());
+                    o.pushKV("blockhash", spender->block_hash.GetHex());
                 }
 
                 result.push_back(std::move(o));
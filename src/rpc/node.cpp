@@ -10,12 +10,14 @@
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
 #include <index/txindex.h>
+#include <index/txospenderindex.h>
 #include <interfaces/chain.h>
 #include <interfaces/echo.h>
 #include <interfaces/init.h>
 #include <interfaces/ipc.h>
 #include <kernel/cs_main.h>
 #include <logging.h>
+#include <node/blockstorage.h>
 #include <node/context.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
@@ -25,6 +27,7 @@
 #include <util/any.h>
 #include <util/check.h>
 #include <util/time.h>
+#include <validation.h>
 
 #include <stdint.h>
 #ifdef HAVE_MALLOC_INFO
@@ -118,6 +121,17 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCBlockServeCacheInfo(const node::BlockManager& blockman)
+{
+    const node::BlockDataCache::Stats stats{blockman.GetServeCacheStats()};
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(stats.entries));
+    obj.pushKV("usage", uint64_t(stats.usage));
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -162,6 +176,13 @@ static RPCHelpMan getmemoryinfo()
                                 {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                                 {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                             }},
+                            {RPCResult::Type::OBJ, "blockservecache", /*optional=*/true, "Information about the cache of recently served blocks (see -blockservecache)",
+                            {
+                                {RPCResult::Type::NUM, "entries", "Number of blocks in the cache"},
+                                {RPCResult::Type::NUM, "usage", "Estimated memory usage of the cache in bytes"},
+                                {RPCResult::Type::NUM, "hits", "Number of block reads served from the cache"},
+                                {RPCResult::Type::NUM, "misses", "Number of block reads that had to go to disk"},
+                            }},
                         }
                     },
                     RPCResult{"mode \"mallocinfo\"",
@@ -178,6 +199,10 @@ static RPCHelpMan getmemoryinfo()
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        const NodeContext& node{EnsureAnyNodeContext(request.context)};
+        if (node.chainman) {
+            obj.pushKV("blockservecache", RPCBlockServeCacheInfo(node.chainman->m_blockman));
+        }
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -391,6 +416,10 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
     }
 
+    if (g_txospenderindex) {
+        result.pushKVs(SummaryToJSON(g_txospenderindex->GetSummary(), index_name));
+    }
+
     ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
@@ -8,6 +8,34 @@
 #include <util/fs_helpers.h>
 
 #include <array>
+#include <cassert>
+#include <cstring>
+
+namespace util {
+void XorWords(Span<std::byte> write, Span<const std::byte> key, size_t key_offset)
+{
+    assert(key.size() == sizeof(uint64_t));
+    // XOR a word at a time, with the key rotated to line up with the offset.
+    // Compilers turn this loop into SIMD instructions where available.
+    std::array<std::byte, sizeof(uint64_t)> rotated;
+    for (size_t i = 0; i < rotated.size(); ++i) {
+        rotated[i] = key[(key_offset + i) % rotated.size()];
+    }
+    uint64_t key_word;
+    std::memcpy(&key_word, rotated.data(), sizeof(key_word));
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= write.size(); i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, write.data() + i, sizeof(word));
+        word ^= key_word;
+        std::memcpy(write.data() + i, &word, sizeof(word));
+    }
+    for (; i != write.size(); ++i) {
+        write[i] ^= rotated[i % rotated.size()];
+    }
+}
+} // namespace util
 
 AutoFile::AutoFile(std::FILE* file, std::vector<std::byte> data_xor)
     : m_file{file}, m_xor{std::move(data_xor)}
@@ -354,6 +354,39 @@ BOOST_AUTO_TEST_CASE(ReceiveWithExtraTransactions) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(ReconstructFromLargeMempool)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    TestMemPoolEntryHelper entry;
+    auto rand_ctx(FastRandomContext(uint256{42}));
+    CBlock block(BuildBlockTestCase(rand_ctx));
+
+    LOCK2(cs_main, pool.cs);
+    // Most of the mempool is not in the block, and has to be skipped while
+    // looking for the transactions that are.
+    for (int i = 0; i < 1000; ++i) {
+        CMutableTransaction mtx = BuildTransactionTestCase();
+        mtx.vin[0].prevout.hash = Txid::FromUint256(rand_ctx.rand256());
+        AddToMempool(pool, entry.FromTx(mtx));
+    }
+    AddToMempool(pool, entry.FromTx(block.vtx[1]));
+    AddToMempool(pool, entry.FromTx(block.vtx[2]));
+
+    const CBlockHeaderAndShortTxIDs cmpctblock{block, rand_ctx.rand64()};
+    PartiallyDownloadedBlock partial_block(&pool);
+    BOOST_CHECK(partial_block.InitData(cmpctblock, empty_extra_txn) == READ_STATUS_OK);
+    BOOST_CHECK(partial_block.IsTxAvailable(0));
+    BOOST_CHECK(partial_block.IsTxAvailable(1));
+    BOOST_CHECK(partial_block.IsTxAvailable(2));
+
+    CBlock block2;
+    BOOST_CHECK(partial_block.FillBlock(block2, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block2.GetHash(), block.GetHash());
+    bool mutated;
+    BOOST_CHECK_EQUAL(BlockMerkleRoot(block2, &mutated), block.hashMerkleRoot);
+    BOOST_CHECK(!mutated);
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = m_rng.rand256();
@@ -5,6 +5,8 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <clientversion.h>
+#include <consensus/consensus.h>
+#include <core_memusage.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/kernel_notifications.h>
@@ -17,10 +19,16 @@
 #include <test/util/logging.h>
 #include <test/util/setup_common.h>
 
+#include <algorithm>
+#include <vector>
+
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
+using node::BlockDataCache;
 using node::BlockManager;
+using node::BlockReorderBuffer;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
+using node::ReindexBlock;
 
 // use BasicTestingSetup here for the data directory configuration, setup, and cleanup
 BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BasicTestingSetup)
@@ -137,6 +145,37 @@ BOOST_FIXTURE_TEST_CASE(blockmanager_block_data_availability, TestChain100Setup)
     BOOST_CHECK(!blockman.CheckBlockDataAvailability(tip, *last_pruned_block));
 }
 
+BOOST_FIXTURE_TEST_CASE(blockmanager_block_indices_by_height, TestChain100Setup)
+{
+    LOCK(::cs_main);
+    auto& blockman{m_node.chainman->m_blockman};
+
+    const auto check_sorted{[&] {
+        const std::vector<CBlockIndex*> sorted{blockman.GetAllBlockIndicesByHeight()};
+        std::vector<CBlockIndex*> expected{blockman.GetAllBlockIndices()};
+        BOOST_CHECK_EQUAL(sorted.size(), expected.size());
+        BOOST_CHECK(std::is_sorted(sorted.begin(), sorted.end(), node::CBlockIndexHeightOnlyComparator()));
+        std::vector<CBlockIndex*> sorted_by_ptr{sorted};
+        std::sort(sorted_by_ptr.begin(), sorted_by_ptr.end());
+        std::sort(expected.begin(), expected.end());
+        BOOST_CHECK(sorted_by_ptr == expected);
+    }};
+
+    // A stale block at the same height as a block in the active chain.
+    CBlockHeader header{m_node.chainman->ActiveChain()[50]->GetBlockHeader()};
+    header.nNonce ^= 1;
+    header.hashPrevBlock = m_node.chainman->ActiveChain()[49]->GetBlockHash();
+    CBlockIndex* stale{blockman.AddToBlockIndex(header, m_node.chainman->m_best_header)};
+    BOOST_CHECK_EQUAL(stale->nHeight, 50);
+    check_sorted();
+
+    // Non-contiguous heights take the comparison sort path.
+    stale->nHeight = 1000;
+    check_sorted();
+    BOOST_CHECK_EQUAL(blockman.GetAllBlockIndicesByHeight().back(), stale);
+    stale->nHeight = 50;
+}
+
 BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
 {
     KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
@@ -206,4 +245,217 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_serve_cache)
+{
+    const auto make_data{[](uint8_t fill) { return std::make_shared<const std::vector<uint8_t>>(1000, fill); }};
+    const auto make_pos{[](int n) { return FlatFilePos{n / 2, uint32_t(8 + 1008 * (n % 2))}; }};
+
+    // Measure the usage of a single entry to size the cache for three of them.
+    size_t entry_usage;
+    {
+        BlockDataCache cache{1 << 20};
+        cache.Put(make_pos(0), make_data(0), cache.GetEraseCount());
+        entry_usage = cache.GetStats().usage;
+        BOOST_CHECK_GE(entry_usage, 1000U);
+    }
+
+    BlockDataCache cache{entry_usage * 3};
+    BOOST_CHECK(!cache.Get(make_pos(0)));
+    for (int n{0}; n < 10; ++n) {
+        cache.Put(make_pos(n), make_data(n), cache.GetEraseCount());
+        // The least recently used blocks are evicted to stay within the limit.
+        const auto stats{cache.GetStats()};
+        BOOST_CHECK_EQUAL(stats.entries, std::min(n + 1, 3));
+        BOOST_CHECK_LE(stats.usage, entry_usage * 3);
+    }
+    auto stats{cache.GetStats()};
+    BOOST_CHECK_EQUAL(stats.hits, 0U);
+    BOOST_CHECK_EQUAL(stats.misses, 1U);
+    for (int n{0}; n < 7; ++n) {
+        BOOST_CHECK(!cache.Get(make_pos(n)));
+    }
+    for (int n{7}; n < 10; ++n) {
+        BOOST_REQUIRE(cache.Get(make_pos(n)));
+        BOOST_CHECK_EQUAL(cache.Get(make_pos(n))->front(), n);
+    }
+    stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.hits, 6U);
+    BOOST_CHECK_EQUAL(stats.misses, 8U);
+
+    // Touch block 7, so that block 8 is the least recently used and gets evicted.
+    BOOST_CHECK(cache.Get(make_pos(7)));
+    cache.Put(make_pos(10), make_data(10), cache.GetEraseCount());
+    BOOST_CHECK(cache.Get(make_pos(7)));
+    BOOST_CHECK(!cache.Get(make_pos(8)));
+    BOOST_CHECK(cache.Get(make_pos(9)));
+    BOOST_CHECK(cache.Get(make_pos(10)));
+
+    // Adding a block that is already cached changes nothing.
+    cache.Put(make_pos(10), make_data(0), cache.GetEraseCount());
+    BOOST_CHECK_EQUAL(cache.Get(make_pos(10))->front(), 10);
+    stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.entries, 3U);
+    BOOST_CHECK_EQUAL(stats.usage, entry_usage * 3);
+
+    // A block larger than the whole cache is not added.
+    cache.Put(make_pos(11), std::make_shared<const std::vector<uint8_t>>(entry_usage * 3, 0), cache.GetEraseCount());
+    BOOST_CHECK(!cache.Get(make_pos(11)));
+    BOOST_CHECK_EQUAL(cache.GetStats().entries, 3U);
+
+    // Pruning a file drops its blocks only. Blocks 9 and 10 are in file 4 and 5.
+    cache.EraseFiles({5});
+    BOOST_CHECK(cache.Get(make_pos(9)));
+    BOOST_CHECK(!cache.Get(make_pos(10)));
+    stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.entries, 2U);
+    BOOST_CHECK_EQUAL(stats.usage, entry_usage * 2);
+
+    // A block read before its file was pruned is not added back.
+    const uint64_t erase_count{cache.GetEraseCount()};
+    cache.EraseFiles({6});
+    cache.Put(make_pos(12), make_data(12), erase_count);
+    BOOST_CHECK(!cache.Get(make_pos(12)));
+    cache.Put(make_pos(12), make_data(12), cache.GetEraseCount());
+    BOOST_CHECK(cache.Get(make_pos(12)));
+
+    // A disabled cache stores nothing and does not count lookups.
+    BlockDataCache disabled{0};
+    disabled.Put(make_pos(0), make_data(0), disabled.GetEraseCount());
+    BOOST_CHECK(!disabled.Get(make_pos(0)));
+    stats = disabled.GetStats();
+    BOOST_CHECK_EQUAL(stats.entries, 0U);
+    BOOST_CHECK_EQUAL(stats.misses, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_serve_cache_prune)
+{
+    KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
+    node::BlockManager::Options blockman_opts{
+        .chainparams = Params(),
+        .serve_cache_bytes = 1 << 20,
+        .blocks_dir = m_args.GetBlocksDirPath(),
+        .notifications = notifications,
+        .block_tree_db_params = DBParams{
+            .path = m_args.GetDataDirNet() / "blocks" / "index",
+            .cache_bytes = 0,
+        },
+    };
+    BlockManager blockman{*Assert(m_node.shutdown_signal), blockman_opts};
+
+    // Write one block to each of the first two block files.
+    CBlock block1;
+    block1.nVersion = 1;
+    CBlock block2;
+    block2.nVersion = 2;
+    const FlatFilePos pos1{blockman.WriteBlock(block1, /*nHeight=*/1)};
+    WITH_LOCK(::cs_main, blockman.GetBlockFileInfo(pos1.nFile)->nSize = MAX_BLOCKFILE_SIZE);
+    const FlatFilePos pos2{blockman.WriteBlock(block2, /*nHeight=*/2)};
+    BOOST_REQUIRE_EQUAL(pos1.nFile, 0);
+    BOOST_REQUIRE_EQUAL(pos2.nFile, 1);
+
+    BOOST_CHECK(blockman.ReadRawBlockCached(pos1));
+    BOOST_CHECK(blockman.ReadRawBlockCached(pos2));
+    BOOST_CHECK(blockman.ReadRawBlockCached(pos1));
+    auto stats{blockman.GetServeCacheStats()};
+    BOOST_CHECK_EQUAL(stats.entries, 2U);
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+
+    // Pruning the first file drops its block from the cache, so it is no longer served.
+    blockman.UnlinkPrunedFiles({0});
+    stats = blockman.GetServeCacheStats();
+    BOOST_CHECK_EQUAL(stats.entries, 1U);
+    BOOST_CHECK(!blockman.ReadRawBlockCached(pos1));
+    BOOST_CHECK(blockman.ReadRawBlockCached(pos2));
+    stats = blockman.GetServeCacheStats();
+    BOOST_CHECK_EQUAL(stats.entries, 1U);
+    BOOST_CHECK_EQUAL(stats.hits, 2U);
+    BOOST_CHECK_EQUAL(stats.misses, 3U);
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_read_block_file)
+{
+    const MessageStartChars& message_start{Params().MessageStart()};
+    CBlock block1;
+    block1.nVersion = 1;
+    CBlock block2;
+    block2.nVersion = 2;
+
+    DataStream stream;
+    const auto write_block{[&](const CBlock& block) {
+        stream << message_start << uint32_t(GetSerializeSize(TX_WITH_WITNESS(block)));
+        const auto pos{stream.size()};
+        stream << TX_WITH_WITNESS(block);
+        return pos;
+    }};
+    // Data that is not a block, before, between and after the blocks, is skipped.
+    stream << std::string{"junk"};
+    const auto pos1{write_block(block1)};
+    // Too large to be a block
+    stream << message_start << uint32_t{MAX_BLOCK_SERIALIZED_SIZE + 1};
+    // Claims more transactions than fit in its size
+    stream << message_start << uint32_t{81} << CBlockHeader{block1} << uint8_t{5};
+    const auto pos2{write_block(block2)};
+    stream << message_start;
+
+    const fs::path path{m_args.GetDataDirBase() / "blk.dat"};
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        file << Span{stream};
+        BOOST_REQUIRE_EQUAL(file.fclose(), 0);
+    }
+    AutoFile file{fsbridge::fopen(path, "rb")};
+    const auto blocks{node::ReadBlockFile(file, /*file_num=*/7, message_start, *Assert(m_node.shutdown_signal))};
+    BOOST_REQUIRE_EQUAL(blocks.size(), 2U);
+    BOOST_CHECK_EQUAL(blocks[0].block->nVersion, 1);
+    BOOST_CHECK_EQUAL(blocks[0].pos.ToString(), FlatFilePos(7, pos1).ToString());
+    BOOST_CHECK_EQUAL(blocks[1].block->nVersion, 2);
+    BOOST_CHECK_EQUAL(blocks[1].pos.ToString(), FlatFilePos(7, pos2).ToString());
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_reorder_buffer)
+{
+    const uint256 parent_a{uint256::ONE};
+    const uint256 parent_b{uint256::ZERO};
+    const auto make_child{[](const uint256& parent, int n) {
+        auto block{std::make_shared<CBlock>()};
+        block->hashPrevBlock = parent;
+        block->nVersion = n;
+        block->vtx.push_back(MakeTransactionRef(CMutableTransaction{}));
+        return ReindexBlock{block, FlatFilePos{0, uint32_t(n)}};
+    }};
+    const size_t block_usage{RecursiveDynamicUsage(*make_child(parent_a, 0).block)};
+    BOOST_REQUIRE_GT(block_usage, 0U);
+
+    // Room for two blocks. The third is only kept by position.
+    BlockReorderBuffer buffer{block_usage * 2};
+    buffer.Add(make_child(parent_a, 1));
+    buffer.Add(make_child(parent_b, 2));
+    buffer.Add(make_child(parent_a, 3));
+    BOOST_CHECK_EQUAL(buffer.Size(), 3U);
+    BOOST_CHECK_EQUAL(buffer.DynamicMemoryUsage(), block_usage * 2);
+
+    // Children are returned in the order they were added.
+    auto children{buffer.Take(parent_a)};
+    BOOST_REQUIRE_EQUAL(children.size(), 2U);
+    BOOST_CHECK_EQUAL(children[0].block->nVersion, 1);
+    BOOST_CHECK(!children[1].block);
+    BOOST_CHECK_EQUAL(children[1].pos.nPos, 3U);
+    BOOST_CHECK_EQUAL(buffer.Size(), 1U);
+    BOOST_CHECK_EQUAL(buffer.DynamicMemoryUsage(), block_usage);
+    BOOST_CHECK(buffer.Take(parent_a).empty());
+
+    // Taken blocks make room for new ones.
+    buffer.Add(make_child(parent_a, 4));
+    BOOST_CHECK_EQUAL(buffer.DynamicMemoryUsage(), block_usage * 2);
+    children = buffer.Take(parent_a);
+    BOOST_REQUIRE_EQUAL(children.size(), 1U);
+    BOOST_CHECK_EQUAL(children[0].block->nVersion, 4);
+    children = buffer.Take(parent_b);
+    BOOST_REQUIRE_EQUAL(children.size(), 1U);
+    BOOST_CHECK_EQUAL(children[0].block->nVersion, 2);
+    BOOST_CHECK_EQUAL(buffer.Size(), 0U);
+    BOOST_CHECK_EQUAL(buffer.DynamicMemoryUsage(), 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1049,6 +1049,53 @@ BOOST_FIXTURE_TEST_CASE(ccoins_flush_behavior, FlushTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_db_partial_batches)
+{
+    // Use a tiny batch size so that the flush is split into many partial
+    // batches, which are committed while the next one is being filled.
+    CCoinsViewDB db{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {.batch_write_bytes = 1024}};
+    std::map<COutPoint, Coin> expected;
+    for (int round{0}; round < 3; ++round) {
+        CCoinsViewCacheTest cache{&db};
+        // Spend some of the coins written in the previous round.
+        for (auto it{expected.begin()}; it != expected.end();) {
+            if (m_rng.randbool()) {
+                BOOST_CHECK(cache.SpendCoin(it->first));
+                it = expected.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (int i{0}; i < 1000; ++i) {
+            const COutPoint outpoint{Txid::FromUint256(m_rng.rand256()), uint32_t(m_rng.randrange(10))};
+            Coin coin;
+            coin.out.nValue = m_rng.randrange(MAX_MONEY) + 1;
+            coin.out.scriptPubKey.assign(m_rng.randrange(64) + 1, OP_TRUE);
+            coin.nHeight = round + 1;
+            cache.AddCoin(outpoint, Coin{coin}, /*possible_overwrite=*/false);
+            expected.emplace(outpoint, std::move(coin));
+        }
+        const uint256 best_block{m_rng.rand256()};
+        cache.SetBestBlock(best_block);
+        BOOST_CHECK(cache.Flush());
+        BOOST_CHECK_EQUAL(db.GetBestBlock(), best_block);
+        BOOST_CHECK(db.GetHeadBlocks().empty());
+    }
+
+    size_t found{0};
+    for (auto cursor{db.Cursor()}; cursor->Valid(); cursor->Next()) {
+        COutPoint outpoint;
+        Coin coin;
+        BOOST_REQUIRE(cursor->GetKey(outpoint));
+        BOOST_REQUIRE(cursor->GetValue(coin));
+        const auto it{expected.find(outpoint)};
+        BOOST_REQUIRE(it != expected.end());
+        BOOST_CHECK(coin == it->second);
+        ++found;
+    }
+    BOOST_CHECK_EQUAL(found, expected.size());
+}
+
 BOOST_AUTO_TEST_CASE(coins_resource_is_used)
 {
     CCoinsMapMemoryResource resource;
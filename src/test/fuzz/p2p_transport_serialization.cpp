@@ -166,6 +166,8 @@ void SimulationTest(Transport& initiator, Transport& responder, R& rng, FuzzedDa
         size_t size = provider.ConsumeIntegralInRange<uint32_t>(0, 75000);
         // Get payload of message from RNG.
         msg.data = rng.randbytes(size);
+        // Sometimes share the payload, like a message sent to many peers.
+        if (rng.randbool()) msg.Share();
         // Return.
         return msg;
     };
@@ -279,7 +281,7 @@ void SimulationTest(Transport& initiator, Transport& responder, R& rng, FuzzedDa
                 // The m_type must match what is expected.
                 assert(received.m_type == expected[side].front().m_type);
                 // The data must match what is expected.
-                assert(std::ranges::equal(received.m_recv, MakeByteSpan(expected[side].front().data)));
+                assert(std::ranges::equal(received.m_recv, MakeByteSpan(expected[side].front().Payload())));
                 expected[side].pop_front();
                 progress = true;
             }
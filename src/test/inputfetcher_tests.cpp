@@ -0,0 +1,134 @@
+// Copyright (c) 2024-present The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <inputfetcher.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace {
+//! Coins view backed by a map that records how many dirty entries were written to it.
+class CoinsViewMap : public CCoinsView
+{
+public:
+    std::map<COutPoint, Coin> m_coins;
+    size_t m_dirty_writes{0};
+
+    std::optional<Coin> GetCoin(const COutPoint& outpoint) const override
+    {
+        if (auto it{m_coins.find(outpoint)}; it != m_coins.end()) return it->second;
+        return std::nullopt;
+    }
+
+    bool BatchWrite(CoinsViewCacheCursor& cursor, const uint256& hashBlock) override
+    {
+        for (auto it{cursor.Begin()}; it != cursor.End(); it = cursor.NextAndMaybeErase(*it)) {
+            if (it->second.IsDirty()) ++m_dirty_writes;
+        }
+        return true;
+    }
+};
+
+Coin MakeCoin(FastRandomContext& rng)
+{
+    CScript script;
+    script << rng.randbytes(20);
+    return Coin{CTxOut{int64_t(rng.randrange(1'000'000) + 1), script}, int(rng.randrange(1000)) + 1, /*fCoinBaseIn=*/false};
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(inputfetcher_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(fetch_inputs)
+{
+    CoinsViewMap db;
+    std::vector<COutPoint> prevouts;
+    for (int i{0}; i < 500; ++i) {
+        const COutPoint outpoint{Txid::FromUint256(m_rng.rand256()), uint32_t(m_rng.randrange(4))};
+        db.m_coins.emplace(outpoint, MakeCoin(m_rng));
+        prevouts.push_back(outpoint);
+    }
+
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    for (size_t i{0}; i < prevouts.size(); i += 5) {
+        CMutableTransaction tx;
+        for (size_t j{i}; j < i + 5; ++j) tx.vin.emplace_back(prevouts[j]);
+        tx.vout.resize(1);
+        block.vtx.push_back(MakeTransactionRef(tx));
+    }
+    // A transaction spending an output created in the same block, and one
+    // spending a coin that does not exist.
+    const COutPoint in_block{block.vtx[1]->GetHash(), 0};
+    const COutPoint missing{Txid::FromUint256(m_rng.rand256()), 0};
+    CMutableTransaction child;
+    child.vin.emplace_back(in_block);
+    child.vin.emplace_back(missing);
+    child.vout.resize(1);
+    block.vtx.push_back(MakeTransactionRef(child));
+
+    CCoinsViewCache cache{&db};
+    // A coin that was already spent in the cache must not be resurrected.
+    BOOST_CHECK(cache.SpendCoin(prevouts[0]));
+    // A coin that is already cached is not fetched again.
+    BOOST_CHECK(cache.HaveCoin(prevouts[1]));
+    const size_t usage_before{cache.DynamicMemoryUsage()};
+
+    InputFetcher fetcher{/*batch_size=*/8, /*worker_threads_num=*/3};
+    fetcher.FetchInputs(cache, db, block);
+
+    BOOST_CHECK(!cache.HaveCoinInCache(prevouts[0]));
+    for (size_t i{1}; i < prevouts.size(); ++i) {
+        BOOST_CHECK(cache.HaveCoinInCache(prevouts[i]));
+        BOOST_CHECK(cache.AccessCoin(prevouts[i]).out == db.m_coins.at(prevouts[i]).out);
+    }
+    BOOST_CHECK(!cache.HaveCoinInCache(in_block));
+    BOOST_CHECK(!cache.HaveCoinInCache(missing));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), prevouts.size());
+    BOOST_CHECK_GT(cache.DynamicMemoryUsage(), usage_before);
+    cache.SanityCheck();
+
+    // Fetched coins are unmodified, so only the spent coin is written back.
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(db.m_dirty_writes, 1U);
+
+    // Fetching again is a no-op for coins that are now cached, and the
+    // fetcher can be reused for another block.
+    CCoinsViewCache cache2{&db};
+    fetcher.FetchInputs(cache2, db, block);
+    fetcher.FetchInputs(cache2, db, block);
+    BOOST_CHECK_EQUAL(cache2.GetCacheSize(), prevouts.size());
+}
+
+BOOST_AUTO_TEST_CASE(no_worker_threads)
+{
+    CoinsViewMap db;
+    const COutPoint outpoint{Txid::FromUint256(m_rng.rand256()), 0};
+    db.m_coins.emplace(outpoint, MakeCoin(m_rng));
+
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(CMutableTransaction{}));
+    CMutableTransaction tx;
+    tx.vin.emplace_back(outpoint);
+    block.vtx.push_back(MakeTransactionRef(tx));
+
+    CCoinsViewCache cache{&db};
+    InputFetcher fetcher{/*batch_size=*/8, /*worker_threads_num=*/0};
+    BOOST_CHECK(!fetcher.HasThreads());
+    fetcher.FetchInputs(cache, db, block);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
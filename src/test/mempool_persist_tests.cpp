@@ -0,0 +1,51 @@
+// Copyright (c) 2025 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <node/mempool_persist.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <util/fs.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+using node::DumpMempool;
+using node::LoadMempool;
+
+BOOST_AUTO_TEST_SUITE(mempool_persist_tests)
+
+BOOST_FIXTURE_TEST_CASE(load_truncated_mempool, TestChain100Setup)
+{
+    CTxMemPool& pool{*Assert(m_node.mempool)};
+    Chainstate& chainstate{Assert(m_node.chainman)->ActiveChainstate()};
+    const CScript spk{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+
+    // A chain of three transactions, dumped parent first.
+    const CTransactionRef parent{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], /*input_vout=*/0, /*input_height=*/1, coinbaseKey, spk, 49 * COIN))};
+    const CTransactionRef child{MakeTransactionRef(CreateValidMempoolTransaction(parent, /*input_vout=*/0, /*input_height=*/101, coinbaseKey, spk, 48 * COIN))};
+    const CTransactionRef grandchild{MakeTransactionRef(CreateValidMempoolTransaction(child, /*input_vout=*/0, /*input_height=*/101, coinbaseKey, spk, 47 * COIN))};
+    BOOST_REQUIRE_EQUAL(pool.size(), 3U);
+
+    const fs::path path{m_args.GetDataDirNet() / "mempool_truncated.dat"};
+    BOOST_REQUIRE(DumpMempool(pool, path, fsbridge::fopen, /*skip_file_commit=*/true));
+    WITH_LOCK(pool.cs, pool.removeRecursive(*parent, MemPoolRemovalReason::REPLACED));
+    BOOST_REQUIRE_EQUAL(pool.size(), 0U);
+
+    // Cut the file in the middle of the last entry's fee delta. The empty
+    // fee delta map and unbroadcast set take one byte each.
+    fs::resize_file(path, fs::file_size(path) - 2 - 4);
+
+    // Loading fails, but the complete entries before the truncated one are
+    // still added.
+    BOOST_CHECK(!LoadMempool(pool, path, chainstate, {}));
+    BOOST_CHECK_EQUAL(pool.size(), 2U);
+    BOOST_CHECK(pool.exists(GenTxid::Txid(parent->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(child->GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(grandchild->GetHash())));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include <test/util/txmempool.h>
 #include <txmempool.h>
 #include <util/time.h>
+#include <util/translation.h>
 
 #include <test/util/setup_common.h>
 
@@ -583,6 +584,65 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     // ... unless it has gone all the way to 0 (after getting past 1000/2)
 }
 
+BOOST_AUTO_TEST_CASE(MempoolSizeLimitBatchTest)
+{
+    // TrimToSize evicts several packages at once where it can. Check that it
+    // evicts exactly the same transactions as removing the package with the
+    // lowest descendant score one at a time.
+    bilingual_str error;
+    CTxMemPool pool{MemPoolOptionsForTest(m_node), error};
+    CTxMemPool reference{MemPoolOptionsForTest(m_node), error};
+    LOCK2(cs_main, pool.cs);
+    LOCK(reference.cs);
+    TestMemPoolEntryHelper entry;
+
+    std::vector<CTransactionRef> txs;
+    std::vector<COutPoint> unspent;
+    for (int i{0}; i < 300; ++i) {
+        CMutableTransaction tx;
+        // Mix unrelated transactions with chains and diamonds.
+        const int num_parents{unspent.empty() ? 0 : int(m_rng.randrange(3))};
+        for (int j{0}; j < num_parents && !unspent.empty(); ++j) {
+            const size_t pos{m_rng.randrange(unspent.size())};
+            tx.vin.emplace_back(unspent[pos]);
+            unspent.erase(unspent.begin() + pos);
+        }
+        if (tx.vin.empty()) tx.vin.emplace_back(Txid::FromUint256(m_rng.rand256()), 0);
+        tx.vout.resize(2);
+        for (auto& out : tx.vout) {
+            out.scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+            out.nValue = COIN;
+        }
+        const CTransactionRef ptx{MakeTransactionRef(tx)};
+        unspent.emplace_back(ptx->GetHash(), 0);
+        unspent.emplace_back(ptx->GetHash(), 1);
+        const CAmount fee(m_rng.randrange(20000));
+        AddToMempool(pool, entry.Fee(fee).FromTx(ptx));
+        AddToMempool(reference, entry.Fee(fee).FromTx(ptx));
+        txs.push_back(ptx);
+    }
+    BOOST_CHECK_EQUAL(pool.DynamicMemoryUsage(), reference.DynamicMemoryUsage());
+
+    for (const size_t limit : {reference.DynamicMemoryUsage() - 1, reference.DynamicMemoryUsage() * 3 / 4,
+                               reference.DynamicMemoryUsage() / 4, size_t{0}}) {
+        std::vector<COutPoint> no_spends;
+        pool.TrimToSize(limit, &no_spends);
+        while (reference.size() > 0 && reference.DynamicMemoryUsage() > limit) {
+            reference.removeRecursive(reference.mapTx.get<descendant_score>().begin()->GetTx(), MemPoolRemovalReason::SIZELIMIT);
+        }
+        BOOST_CHECK_EQUAL(pool.size(), reference.size());
+        BOOST_CHECK_EQUAL(pool.DynamicMemoryUsage(), reference.DynamicMemoryUsage());
+        if (pool.size() > 0) BOOST_CHECK_LE(pool.DynamicMemoryUsage(), limit);
+        for (const auto& tx : txs) {
+            BOOST_CHECK_EQUAL(pool.exists(GenTxid::Txid(tx->GetHash())), reference.exists(GenTxid::Txid(tx->GetHash())));
+        }
+        for (const COutPoint& outpoint : no_spends) {
+            BOOST_CHECK(!pool.exists(GenTxid::Txid(outpoint.hash)));
+        }
+    }
+    BOOST_CHECK_EQUAL(pool.size(), 0U);
+}
+
 inline CTransactionRef make_tx(std::vector<CAmount>&& output_values, std::vector<CTransactionRef>&& inputs=std::vector<CTransactionRef>(), std::vector<uint32_t>&& input_indices=std::vector<uint32_t>())
 {
     CMutableTransaction tx = CMutableTransaction();
@@ -804,4 +864,57 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTestsDiamond)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolUpdateTransactionsFromBlock)
+{
+    size_t ancestors, descendants, ancestorsize;
+    CAmount ancestorfees;
+
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Same diamond as above, but ta and tb are re-added to the mempool (e.g.
+    // from a disconnected block) after tc and td, which spend from tb.
+    CTransactionRef ta = make_tx(/*output_values=*/{10 * COIN});
+    CTransactionRef tb = make_tx(/*output_values=*/{5 * COIN, 3 * COIN}, /*inputs=*/ {ta});
+    CTransactionRef tc = make_tx(/*output_values=*/{2 * COIN}, /*inputs=*/{tb}, /*input_indices=*/{1});
+    CTransactionRef td = make_tx(/*output_values=*/{6 * COIN}, /*inputs=*/{tb, tc}, /*input_indices=*/{0, 0});
+    AddToMempool(pool, entry.Fee(3000LL).FromTx(tc));
+    AddToMempool(pool, entry.Fee(4000LL).FromTx(td));
+    AddToMempool(pool, entry.Fee(1000LL).FromTx(ta));
+    AddToMempool(pool, entry.Fee(2000LL).FromTx(tb));
+
+    // tc and td are not linked to their re-added ancestors yet.
+    pool.GetTransactionAncestry(td->GetHash(), ancestors, descendants);
+    BOOST_CHECK_EQUAL(ancestors, 2ULL);
+    pool.GetTransactionAncestry(ta->GetHash(), ancestors, descendants);
+    BOOST_CHECK_EQUAL(descendants, 2ULL);
+
+    pool.UpdateTransactionsFromBlock({ta->GetHash(), tb->GetHash()});
+
+    pool.GetTransactionAncestry(ta->GetHash(), ancestors, descendants, &ancestorsize, &ancestorfees);
+    BOOST_CHECK_EQUAL(ancestors, 1ULL);
+    BOOST_CHECK_EQUAL(descendants, 4ULL);
+    BOOST_CHECK_EQUAL(ancestorfees, 1000);
+    // GetTransactionAncestry reports the largest descendant count of any
+    // ancestor, which is ta's for all of them.
+    pool.GetTransactionAncestry(tb->GetHash(), ancestors, descendants, &ancestorsize, &ancestorfees);
+    BOOST_CHECK_EQUAL(ancestors, 2ULL);
+    BOOST_CHECK_EQUAL(descendants, 4ULL);
+    BOOST_CHECK_EQUAL(ancestorfees, 3000);
+    pool.GetTransactionAncestry(tc->GetHash(), ancestors, descendants, &ancestorsize, &ancestorfees);
+    BOOST_CHECK_EQUAL(ancestors, 3ULL);
+    BOOST_CHECK_EQUAL(descendants, 4ULL);
+    BOOST_CHECK_EQUAL(ancestorfees, 6000);
+    pool.GetTransactionAncestry(td->GetHash(), ancestors, descendants, &ancestorsize, &ancestorfees);
+    BOOST_CHECK_EQUAL(ancestors, 4ULL);
+    BOOST_CHECK_EQUAL(descendants, 4ULL);
+    BOOST_CHECK_EQUAL(ancestorfees, 10000);
+    BOOST_CHECK_EQUAL(ancestorsize, pool.GetTotalTxSize());
+
+    BOOST_CHECK_EQUAL(pool.GetEntry(tb->GetHash())->GetCountWithDescendants(), 3ULL);
+    BOOST_CHECK_EQUAL(pool.GetEntry(tc->GetHash())->GetCountWithDescendants(), 2ULL);
+    BOOST_CHECK_EQUAL(pool.GetEntry(td->GetHash())->GetCountWithDescendants(), 1ULL);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -40,6 +40,7 @@ struct MinerTestingSetup : public TestingSetup {
     void TestPackageSelection(const CScript& scriptPubKey, const std::vector<CTransactionRef>& txFirst) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     void TestBasicMining(const CScript& scriptPubKey, const std::vector<CTransactionRef>& txFirst, int baseheight) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     void TestPrioritisedMining(const CScript& scriptPubKey, const std::vector<CTransactionRef>& txFirst) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    void TestSharedDescendantMining(const CScript& scriptPubKey, const std::vector<CTransactionRef>& txFirst) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool TestSequenceLocks(const CTransaction& tx, CTxMemPool& tx_mempool) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
     {
         CCoinsViewMemPool view_mempool{&m_node.chainman->ActiveChainstate().CoinsTip(), tx_mempool};
@@ -651,6 +652,83 @@ void MinerTestingSetup::TestPrioritisedMining(const CScript& scriptPubKey, const
     }
 }
 
+// Test that the ancestor state of transactions that descend from several
+// transactions of a selected package is updated for all of them.
+void MinerTestingSetup::TestSharedDescendantMining(const CScript& scriptPubKey, const std::vector<CTransactionRef>& txFirst)
+{
+    CTxMemPool& tx_mempool{MakeMempool()};
+    BlockAssembler::Options options;
+    options.coinbase_output_script = scriptPubKey;
+
+    LOCK(tx_mempool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Two parents with a fee of 20000 satoshis each, and two outputs each.
+    std::vector<Txid> parents;
+    FeeFrac parents_feefrac;
+    for (int i = 0; i < 2; ++i) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << OP_1;
+        tx.vin[0].prevout = COutPoint{txFirst[i]->GetHash(), 0};
+        tx.vout.resize(2);
+        tx.vout[0].nValue = 2500000000LL - 10000;
+        tx.vout[1].nValue = 2500000000LL - 10000;
+        parents.push_back(tx.GetHash());
+        const auto parent_entry{entry.Fee(20000).Time(Now<NodeSeconds>()).SpendsCoinbase(true).FromTx(tx)};
+        parents_feefrac += FeeFrac{parent_entry.GetFee(), parent_entry.GetTxSize()};
+        AddToMempool(tx_mempool, parent_entry);
+    }
+
+    // Spends output n of both parents.
+    const auto spend_parents{[&](uint32_t n, CAmount fee) {
+        CMutableTransaction tx;
+        tx.vin.resize(2);
+        for (int i = 0; i < 2; ++i) {
+            tx.vin[i].scriptSig = CScript() << OP_1;
+            tx.vin[i].prevout = COutPoint{parents[i], n};
+        }
+        tx.vout.resize(1);
+        tx.vout[0].nValue = 2 * (2500000000LL - 10000) - fee;
+        return tx;
+    }};
+
+    // A high fee child of both parents, which gets them selected as one package.
+    const CMutableTransaction high_fee_child{spend_parents(0, 100000)};
+    const auto high_fee_child_entry{entry.Fee(100000).SpendsCoinbase(false).FromTx(high_fee_child)};
+    AddToMempool(tx_mempool, high_fee_child_entry);
+
+    // A low fee child of both parents, with a child of its own.
+    const CMutableTransaction low_fee_child{spend_parents(1, 1000)};
+    const auto low_fee_child_entry{entry.Fee(1000).FromTx(low_fee_child)};
+    AddToMempool(tx_mempool, low_fee_child_entry);
+    CMutableTransaction grandchild;
+    grandchild.vin.resize(1);
+    grandchild.vin[0].scriptSig = CScript() << OP_1;
+    grandchild.vin[0].prevout = COutPoint{low_fee_child.GetHash(), 0};
+    grandchild.vout.resize(1);
+    grandchild.vout[0].nValue = low_fee_child.vout[0].nValue - 60000;
+    const auto grandchild_entry{entry.Fee(60000).FromTx(grandchild)};
+    AddToMempool(tx_mempool, grandchild_entry);
+
+    const auto block_template{BlockAssembler{m_node.chainman->ActiveChainstate(), &tx_mempool, options}.CreateNewBlock()};
+    const CBlock& block{block_template->block};
+    BOOST_REQUIRE_EQUAL(block.vtx.size(), 6U);
+    BOOST_CHECK(block.vtx[3]->GetHash() == high_fee_child.GetHash());
+    BOOST_CHECK(block.vtx[4]->GetHash() == low_fee_child.GetHash());
+    BOOST_CHECK(block.vtx[5]->GetHash() == grandchild.GetHash());
+
+    // Once the parents are in the block, neither of them may still count
+    // towards the ancestor state of the low fee child and the grandchild.
+    const auto& package_feerates{block_template->m_package_feerates};
+    BOOST_REQUIRE_EQUAL(package_feerates.size(), 2U);
+    const FeeFrac first_package{parents_feefrac + FeeFrac(high_fee_child_entry.GetFee(), high_fee_child_entry.GetTxSize())};
+    BOOST_CHECK(package_feerates[0] == first_package);
+    const FeeFrac second_package{low_fee_child_entry.GetFee() + grandchild_entry.GetFee(),
+                                 low_fee_child_entry.GetTxSize() + grandchild_entry.GetTxSize()};
+    BOOST_CHECK(package_feerates[1] == second_package);
+}
+
 // NOTE: These tests rely on CreateNewBlock doing its own self-validation!
 BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
 {
@@ -726,6 +804,11 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     SetMockTime(0);
 
     TestPrioritisedMining(scriptPubKey, txFirst);
+
+    m_node.chainman->ActiveChain().Tip()->nHeight--;
+    SetMockTime(0);
+
+    TestSharedDescendantMining(scriptPubKey, txFirst);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
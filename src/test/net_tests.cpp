@@ -1553,4 +1553,56 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(shared_message_payload)
+{
+    const auto payload{m_rng.randbytes<uint8_t>(10000)};
+    const auto make_msg{[&] {
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::BLOCK;
+        msg.data = payload;
+        return msg;
+    }};
+
+    CSerializedNetMsg shared{make_msg()};
+    shared.Share();
+    BOOST_CHECK(shared.data.empty());
+    BOOST_CHECK(std::ranges::equal(shared.Payload(), payload));
+    BOOST_CHECK_GE(shared.GetMemoryUsage(), payload.size());
+
+    // Returns the bytes a v1 transport sends for msg.
+    const auto wire_bytes{[](CSerializedNetMsg&& msg) {
+        V1Transport transport{0};
+        BOOST_REQUIRE(transport.SetMessageToSend(msg));
+        std::vector<uint8_t> bytes;
+        while (true) {
+            const auto& [to_send, _more, _msg_type] = transport.GetBytesToSend(/*have_next_message=*/false);
+            if (to_send.empty()) break;
+            bytes.insert(bytes.end(), to_send.begin(), to_send.end());
+            transport.MarkBytesSent(to_send.size());
+        }
+        BOOST_CHECK_EQUAL(transport.GetSendMemoryUsage(), CSerializedNetMsg{}.GetMemoryUsage());
+        return bytes;
+    }};
+
+    // Every copy of a shared message is sent the same way as an unshared one.
+    const auto expected{wire_bytes(make_msg())};
+    for (int i{0}; i < 3; ++i) {
+        CSerializedNetMsg copy{shared.Copy()};
+        BOOST_CHECK(copy.m_shared_payload == shared.m_shared_payload);
+        BOOST_CHECK(wire_bytes(std::move(copy)) == expected);
+    }
+
+    V1Transport receiver{0};
+    Span<const uint8_t> to_receive{expected};
+    while (!to_receive.empty()) {
+        BOOST_REQUIRE(receiver.ReceivedBytes(to_receive));
+    }
+    BOOST_REQUIRE(receiver.ReceivedMessageComplete());
+    bool reject{false};
+    CNetMessage received{receiver.GetReceivedMessage({}, reject)};
+    BOOST_CHECK(!reject);
+    BOOST_CHECK_EQUAL(received.m_type, NetMsgType::BLOCK);
+    BOOST_CHECK(std::ranges::equal(MakeUCharSpan(received.m_recv), payload));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
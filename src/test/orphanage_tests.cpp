@@ -16,6 +16,7 @@
 
 #include <array>
 #include <cstdint>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -562,4 +563,58 @@ BOOST_AUTO_TEST_CASE(peer_worksets)
         }
     }
 }
+BOOST_AUTO_TEST_CASE(process_orphans_after_last_missing_parent)
+{
+    const NodeId node{0};
+    FastRandomContext det_rand{true};
+    TxOrphanageTest orphanage{det_rand};
+
+    auto parent1 = MakeTransactionSpending({}, det_rand);
+    auto parent2 = MakeTransactionSpending({}, det_rand);
+    auto parent3 = MakeTransactionSpending({}, det_rand);
+    auto child = MakeTransactionSpending({COutPoint{parent1->GetHash(), 0}, COutPoint{parent2->GetHash(), 0},
+                                          COutPoint{parent2->GetHash(), 1}, COutPoint{parent3->GetHash(), 0}}, det_rand);
+    // parent3 is not missing, e.g. it is already in the mempool.
+    const std::vector<Txid> missing_parents{parent1->GetHash(), parent2->GetHash()};
+    BOOST_CHECK(orphanage.AddTx(child, node, missing_parents));
+
+    // Parents that were not missing don't cause the orphan to be reconsidered.
+    orphanage.AddChildrenToWorkSet(*parent3, det_rand);
+    BOOST_CHECK(!orphanage.HaveTxToReconsider(node));
+    // Neither does the arrival of a parent while another one is still missing.
+    orphanage.AddChildrenToWorkSet(*parent1, det_rand);
+    BOOST_CHECK(!orphanage.HaveTxToReconsider(node));
+    orphanage.AddChildrenToWorkSet(*parent2, det_rand);
+    BOOST_CHECK(orphanage.HaveTxToReconsider(node));
+    BOOST_CHECK_EQUAL(orphanage.GetTxToReconsider(node), child);
+    BOOST_CHECK(!orphanage.HaveTxToReconsider(node));
+
+    // Once no parents are known to be missing, any parent causes the orphan to be reconsidered.
+    orphanage.AddChildrenToWorkSet(*parent3, det_rand);
+    BOOST_CHECK_EQUAL(orphanage.GetTxToReconsider(node), child);
+    BOOST_CHECK_EQUAL(orphanage.EraseTx(child->GetWitnessHash()), 1);
+
+    // Parents that arrived without being passed to AddChildrenToWorkSet are detected through
+    // have_parent, and parents confirmed in a block are no longer missing.
+    BOOST_CHECK(orphanage.AddTx(child, node, missing_parents));
+    orphanage.AddChildrenToWorkSet(*parent1, det_rand, [&](const Txid& txid) { return txid == parent2->GetHash(); });
+    BOOST_CHECK_EQUAL(orphanage.GetTxToReconsider(node), child);
+    BOOST_CHECK_EQUAL(orphanage.EraseTx(child->GetWitnessHash()), 1);
+
+    BOOST_CHECK(orphanage.AddTx(child, node, missing_parents));
+    CBlock block;
+    block.vtx.push_back(parent1);
+    orphanage.EraseForBlock(block);
+    BOOST_CHECK(orphanage.HaveTx(child->GetWitnessHash()));
+    BOOST_CHECK(!orphanage.HaveTxToReconsider(node));
+    orphanage.AddChildrenToWorkSet(*parent2, det_rand);
+    BOOST_CHECK_EQUAL(orphanage.GetTxToReconsider(node), child);
+
+    // A block spending one of the orphan's inputs still erases it.
+    auto conflict = MakeTransactionSpending({COutPoint{parent2->GetHash(), 1}}, det_rand);
+    block.vtx.assign({conflict});
+    orphanage.EraseForBlock(block);
+    BOOST_CHECK(!orphanage.HaveTx(child->GetWitnessHash()));
+    orphanage.SanityCheck();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,12 +3,19 @@
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <net.h>
+#include <netmessagemaker.h>
 #include <node/miner.h>
 #include <net_processing.h>
 #include <pow.h>
+#include <protocol.h>
+#include <test/util/net.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
 
+#include <string>
+#include <vector>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(peerman_tests, RegTestingSetup)
@@ -73,4 +80,55 @@ BOOST_AUTO_TEST_CASE(connections_desirable_service_flags)
     BOOST_CHECK(peerman->GetDesirableServiceFlags(peer_flags) == ServiceFlags(NODE_NETWORK | NODE_WITNESS));
 }
 
+BOOST_AUTO_TEST_CASE(serve_block_requests)
+{
+    auto connman{std::make_unique<ConnmanTestMsg>(0x1337, 0x1337, *m_node.addrman, *m_node.netgroupman, Params())};
+    auto peerman{PeerManager::make(*connman, *m_node.addrman, nullptr, *m_node.chainman, *m_node.mempool, *m_node.warnings, {})};
+    connman->SetMsgProc(peerman.get());
+    connman->SetMsgServeThreads(1);
+
+    CNode node{/*id=*/0,
+               /*sock=*/nullptr,
+               CAddress{},
+               /*nKeyedNetGroupIn=*/0,
+               /*nLocalHostNonceIn=*/0,
+               CAddress{},
+               /*addrNameIn=*/"",
+               ConnectionType::INBOUND,
+               /*inbound_onion=*/false};
+    const ServiceFlags services{NODE_NETWORK | NODE_WITNESS};
+    WITH_LOCK(NetEventsInterface::g_msgproc_mutex, connman->Handshake(node, /*successfully_connected=*/true, services, services, PROTOCOL_VERSION, /*relay_txs=*/true));
+    connman->FlushSendBuffer(node);
+
+    const std::vector<CInv> request{{MSG_WITNESS_BLOCK, m_node.chainman->GetParams().GenesisBlock().GetHash()}};
+    const auto process_all{[&] {
+        node.fPauseSend = false;
+        LOCK(NetEventsInterface::g_msgproc_mutex);
+        while (connman->ProcessMessagesOnce(node)) {}
+    }};
+
+    // The block request is left to the serving thread, and holds back the
+    // ping that follows it.
+    (void)connman->ReceiveMsgFrom(node, NetMsg::Make(NetMsgType::GETDATA, request));
+    (void)connman->ReceiveMsgFrom(node, NetMsg::Make(NetMsgType::PING, uint64_t{1}));
+    process_all();
+    BOOST_CHECK(connman->FlushSentMessageTypes(node).empty());
+
+    BOOST_CHECK(!connman->ServeMessagesOnce(node));
+    BOOST_CHECK(connman->FlushSentMessageTypes(node) == std::vector<std::string>{NetMsgType::BLOCK});
+    BOOST_CHECK(!connman->ServeMessagesOnce(node));
+    BOOST_CHECK(connman->FlushSentMessageTypes(node).empty());
+
+    process_all();
+    BOOST_CHECK(connman->FlushSentMessageTypes(node) == std::vector<std::string>{NetMsgType::PONG});
+
+    // Without serving threads, the block is sent by the message handler.
+    connman->SetMsgServeThreads(0);
+    (void)connman->ReceiveMsgFrom(node, NetMsg::Make(NetMsgType::GETDATA, request));
+    process_all();
+    BOOST_CHECK(connman->FlushSentMessageTypes(node) == std::vector<std::string>{NetMsgType::BLOCK});
+
+    peerman->FinalizeNode(node);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -15,6 +15,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <utility>
+#include <vector>
+
 BOOST_FIXTURE_TEST_SUITE(policyestimator_tests, ChainTestingSetup)
 
 BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
@@ -265,4 +268,79 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     }
 }
 
+BOOST_AUTO_TEST_CASE(SmartFeeCache)
+{
+    // Both estimators see the same events. The first one is queried after
+    // every event and so answers from its cache whenever possible, the second
+    // one is only queried at the end.
+    CBlockPolicyEstimator queried{FeeestPath(*m_node.args), DEFAULT_ACCEPT_STALE_FEE_ESTIMATES};
+    CBlockPolicyEstimator reference{FeeestPath(*m_node.args), DEFAULT_ACCEPT_STALE_FEE_ESTIMATES};
+    TestMemPoolEntryHelper entry;
+
+    const auto query_all{[](const CBlockPolicyEstimator& estimator) {
+        std::vector<std::pair<CFeeRate, FeeCalculation>> results;
+        for (bool conservative : {false, true}) {
+            for (int target{1}; target <= 50; ++target) {
+                FeeCalculation calc;
+                const CFeeRate feerate{estimator.estimateSmartFee(target, &calc, conservative)};
+                results.emplace_back(feerate, calc);
+            }
+        }
+        return results;
+    }};
+
+    std::vector<CTransactionRef> unconfirmed;
+    for (unsigned int height{1}; height <= 100; ++height) {
+        std::vector<RemovedMempoolTransactionInfo> block;
+        for (int i{0}; i < 20; ++i) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].prevout.n = 1000 * height + i;
+            tx.vout.resize(1);
+            const CTransactionRef ptx{MakeTransactionRef(tx)};
+            const CAmount fee{1000 * (i + 1)};
+            const NewMempoolTransactionInfo tx_info{ptx, fee, GetVirtualTransactionSize(*ptx), height - 1,
+                                                    /*mempool_limit_bypassed=*/false,
+                                                    /*submitted_in_package=*/false,
+                                                    /*chainstate_is_current=*/true,
+                                                    /*has_no_mempool_parents=*/true};
+            for (auto* estimator : {&queried, &reference}) estimator->processTransaction(tx_info);
+            query_all(queried);
+            // Higher feerate transactions confirm in the next block, the rest
+            // stay unconfirmed for a while or are removed from the mempool.
+            if (i >= 10) {
+                block.emplace_back(entry.Fee(fee).Height(height - 1).FromTx(ptx));
+            } else {
+                unconfirmed.push_back(ptx);
+            }
+        }
+        for (auto* estimator : {&queried, &reference}) estimator->processBlock(block, height);
+        query_all(queried);
+        if (height % 10 == 0) {
+            for (const auto& ptx : unconfirmed) {
+                for (auto* estimator : {&queried, &reference}) estimator->removeTx(ptx->GetHash());
+                query_all(queried);
+            }
+            unconfirmed.clear();
+        }
+    }
+
+    const auto cached_results{query_all(queried)};
+    const auto reference_results{query_all(reference)};
+    BOOST_REQUIRE_EQUAL(cached_results.size(), reference_results.size());
+    bool any_estimate{false};
+    for (size_t i{0}; i < cached_results.size(); ++i) {
+        const auto& [feerate, calc]{cached_results[i]};
+        const auto& [ref_feerate, ref_calc]{reference_results[i]};
+        BOOST_CHECK(feerate == ref_feerate);
+        BOOST_CHECK(calc.reason == ref_calc.reason);
+        BOOST_CHECK_EQUAL(calc.desiredTarget, ref_calc.desiredTarget);
+        BOOST_CHECK_EQUAL(calc.returnedTarget, ref_calc.returnedTarget);
+        BOOST_CHECK_EQUAL(calc.est.pass.totalConfirmed, ref_calc.est.pass.totalConfirmed);
+        BOOST_CHECK_EQUAL(calc.est.fail.leftMempool, ref_calc.est.fail.leftMempool);
+        any_estimate |= feerate != CFeeRate(0);
+    }
+    BOOST_CHECK(any_estimate);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -14,6 +14,35 @@ using namespace std::string_literals;
 
 BOOST_FIXTURE_TEST_SUITE(streams_tests, BasicTestingSetup)
 
+BOOST_AUTO_TEST_CASE(xor_random_chunks)
+{
+    auto apply_random_xor_chunks{[&](std::span<std::byte> target, std::span<const std::byte> key) {
+        for (size_t offset{0}; offset < target.size();) {
+            const size_t chunk_size{1 + m_rng.randrange(target.size() - offset)};
+            util::Xor(target.subspan(offset, chunk_size), key, offset);
+            offset += chunk_size;
+        }
+    }};
+
+    for (size_t test{0}; test < 100; ++test) {
+        const size_t key_size{m_rng.randbool() ? size_t{8} : 1 + m_rng.randrange(size_t{16})};
+        const auto key{m_rng.randbytes<std::byte>(key_size)};
+        const auto original{m_rng.randbytes<std::byte>(1 + m_rng.randrange(1000))};
+
+        // Compare against a plain byte-wise XOR.
+        auto expected{original};
+        for (size_t i{0}; i < expected.size(); ++i) {
+            expected[i] ^= key[i % key_size];
+        }
+
+        auto roundtrip{original};
+        apply_random_xor_chunks(roundtrip, key);
+        BOOST_CHECK(roundtrip == expected);
+        apply_random_xor_chunks(roundtrip, key);
+        BOOST_CHECK(roundtrip == original);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(xor_file)
 {
     fs::path xor_path{m_args.GetDataDirBase() / "test_xor.bin"};
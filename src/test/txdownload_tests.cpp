@@ -338,4 +338,44 @@ BOOST_FIXTURE_TEST_CASE(handle_missing_inputs, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(orphan_with_confirmed_parent, TestChain100Setup)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    FastRandomContext det_rand{true};
+    node::TxDownloadOptions opts{pool, det_rand, DEFAULT_MAX_ORPHAN_TRANSACTIONS, true, m_node.chainman.get()};
+    NodeId nodeid{1};
+    node::TxDownloadConnectionInfo DEFAULT_CONN{/*m_preferred=*/false, /*m_relay_permissions=*/false, /*m_wtxid_relay=*/true};
+
+    // We need 2 mature coinbases
+    mineBlocks(1);
+    const CScript destination{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const int test_chain_height{101};
+
+    TxValidationState state_orphan;
+    state_orphan.Invalid(TxValidationResult::TX_MISSING_INPUTS, "");
+
+    // The old parent is confirmed a few blocks back, so it is neither in the mempool nor in the
+    // recent confirmed filter. The new parent has not arrived yet.
+    const auto mtx_old_parent{CreateValidMempoolTransaction(m_coinbase_txns[0], /*input_vout=*/0, test_chain_height, coinbaseKey, destination, 50 * COIN - 1000, /*submit=*/false)};
+    CreateAndProcessBlock({mtx_old_parent}, destination);
+    mineBlocks(3);
+    const auto old_parent{MakeTransactionRef(mtx_old_parent)};
+    const auto new_parent{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[1], /*input_vout=*/0, test_chain_height, coinbaseKey, destination, 50 * COIN - 1000, /*submit=*/false))};
+    const auto orphan{MakeTransactionRef(CreateValidMempoolTransaction({old_parent, new_parent}, {{old_parent->GetHash(), 0}, {new_parent->GetHash(), 0}},
+                                                                       test_chain_height, {coinbaseKey}, {{100 * COIN - 4000, destination}}, /*submit=*/false))};
+
+    node::TxDownloadManagerImpl txdownload_impl{opts};
+    txdownload_impl.ConnectedPeer(nodeid, DEFAULT_CONN);
+    txdownload_impl.MempoolRejectedTx(orphan, state_orphan, nodeid, /*first_time_failure=*/true);
+    BOOST_CHECK(txdownload_impl.m_orphanage.HaveTx(orphan->GetWitnessHash()));
+    BOOST_CHECK(!txdownload_impl.HaveMoreWork(nodeid));
+
+    // Once the new parent is accepted, the orphan is reconsidered, as the old parent is not missing.
+    const auto mempool_result = WITH_LOCK(::cs_main, return m_node.chainman->ProcessTransaction(new_parent));
+    BOOST_CHECK(mempool_result.m_result_type == MempoolAcceptResult::ResultType::VALID);
+    txdownload_impl.MempoolAcceptedTx(new_parent);
+    BOOST_CHECK(txdownload_impl.HaveMoreWork(nodeid));
+    BOOST_CHECK_EQUAL(txdownload_impl.GetTxToReconsider(nodeid), orphan);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
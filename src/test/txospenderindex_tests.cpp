@@ -0,0 +1,77 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <index/txospenderindex.h>
+#include <interfaces/chain.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(txospenderindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(txospenderindex_spends_and_reorg, TestChain100Setup)
+{
+    TxoSpenderIndex txospenderindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(txospenderindex.Init());
+
+    const CScript script_pub_key{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    // Spend a coinbase output before the index is started, so that it is
+    // picked up by the initial sync.
+    const COutPoint prevout_synced{m_coinbase_txns[0]->GetHash(), 0};
+    const CMutableTransaction tx_synced{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, script_pub_key, 49 * COIN, /*submit=*/false)};
+    const CBlock block_synced{CreateAndProcessBlock({tx_synced}, script_pub_key)};
+
+    BOOST_CHECK(!txospenderindex.FindSpender(prevout_synced));
+    BOOST_REQUIRE(txospenderindex.StartBackgroundSync());
+    IndexWaitSynced(txospenderindex, *Assert(m_node.shutdown_signal));
+
+    auto spender{txospenderindex.FindSpender(prevout_synced)};
+    BOOST_REQUIRE(spender);
+    BOOST_CHECK_EQUAL(spender->txid, tx_synced.GetHash());
+    BOOST_CHECK_EQUAL(spender->height, 101);
+    BOOST_CHECK_EQUAL(spender->block_hash, block_synced.GetHash());
+
+    // Unspent outputs, including those of the spending transaction, are not found.
+    BOOST_CHECK(!txospenderindex.FindSpender({m_coinbase_txns[1]->GetHash(), 0}));
+    BOOST_CHECK(!txospenderindex.FindSpender({tx_synced.GetHash(), 0}));
+
+    // Spends in new blocks make it into the index.
+    const COutPoint prevout_new{m_coinbase_txns[1]->GetHash(), 0};
+    const CMutableTransaction tx_new{CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 2, coinbaseKey, script_pub_key, 49 * COIN, /*submit=*/false)};
+    const CBlock block_new{CreateAndProcessBlock({tx_new}, script_pub_key)};
+    BOOST_CHECK(txospenderindex.BlockUntilSyncedToCurrentChain());
+    spender = txospenderindex.FindSpender(prevout_new);
+    BOOST_REQUIRE(spender);
+    BOOST_CHECK_EQUAL(spender->txid, tx_new.GetHash());
+    BOOST_CHECK_EQUAL(spender->height, 102);
+    BOOST_CHECK_EQUAL(spender->block_hash, block_new.GetHash());
+
+    // Spends in blocks that are reorged out are removed from the index.
+    {
+        BlockValidationState state;
+        const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, const_cast<CBlockIndex*>(tip)));
+    }
+    CreateAndProcessBlock({}, script_pub_key);
+    CreateAndProcessBlock({}, script_pub_key);
+    BOOST_CHECK(txospenderindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(!txospenderindex.FindSpender(prevout_new));
+    BOOST_CHECK(txospenderindex.FindSpender(prevout_synced));
+
+    // It is not safe to stop and destroy the index until it finishes handling
+    // the last BlockConnected notification. The BlockUntilSyncedToCurrentChain()
+    // call above is sufficient to ensure this, but the
+    // SyncWithValidationInterfaceQueue() call below is also needed to ensure
+    // TSAN always sees the test thread waiting for the notification thread, and
+    // avoid potential false positive reports.
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    txospenderindex.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
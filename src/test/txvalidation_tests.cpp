@@ -11,6 +11,7 @@
 #include <primitives/transaction.h>
 #include <random.h>
 #include <script/script.h>
+#include <script/solver.h>
 #include <test/util/setup_common.h>
 #include <test/util/txmempool.h>
 #include <validation.h>
@@ -570,4 +571,69 @@ BOOST_FIXTURE_TEST_CASE(version3_tests, RegTestingSetup)
     // equivalent to the tx with multiple generations of ancestors.
 }
 
+BOOST_FIXTURE_TEST_CASE(prewarm_script_checks, TestChain100Setup)
+{
+    // Checking scripts on the script check threads first, either in
+    // MemPoolAccept or through PrewarmSignatureCache, must not change the
+    // result of mempool validation, also when an input is invalid.
+    // Mature the coinbase outputs spent below.
+    mineBlocks(6);
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    BOOST_REQUIRE(m_node.chainman->GetCheckQueue().HasThreads());
+    const CScript spk{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+
+    const auto create_tx{[&](const std::vector<CTransactionRef>& parents, bool invalid) {
+        std::vector<COutPoint> inputs;
+        CAmount total{0};
+        for (const auto& parent : parents) {
+            inputs.emplace_back(parent->GetHash(), 0);
+            total += parent->vout[0].nValue;
+        }
+        CMutableTransaction mtx{CreateValidMempoolTransaction(parents, inputs, /*input_height=*/1, {coinbaseKey},
+                                                              {CTxOut{total - 10000, spk}}, /*submit=*/false)};
+        if (invalid) {
+            // Keep the signature canonical, but commit to another sighash type.
+            CScript& script_sig{mtx.vin.back().scriptSig};
+            *(script_sig.end() - 1) = SIGHASH_SINGLE;
+        }
+        return MakeTransactionRef(mtx);
+    }};
+    const auto check_same{[](const MempoolAcceptResult& prewarmed, const MempoolAcceptResult& serial) {
+        BOOST_CHECK(prewarmed.m_result_type == serial.m_result_type);
+        BOOST_CHECK(prewarmed.m_state.GetResult() == serial.m_state.GetResult());
+        BOOST_CHECK_EQUAL(prewarmed.m_state.GetRejectReason(), serial.m_state.GetRejectReason());
+        BOOST_CHECK_EQUAL(prewarmed.m_state.GetDebugMessage(), serial.m_state.GetDebugMessage());
+    }};
+    const auto accept{[&](const CTransactionRef& tx, bool test_accept, bool scripts_prewarmed) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+        return AcceptToMemoryPool(chainstate, tx, GetTime(), /*bypass_limits=*/false, test_accept, scripts_prewarmed);
+    }};
+
+    LOCK(cs_main);
+    // Single transactions, prewarmed by MemPoolAccept or not.
+    for (const bool invalid : {false, true}) {
+        const auto tx{create_tx({m_coinbase_txns[invalid ? 2 : 0], m_coinbase_txns[invalid ? 3 : 1]}, invalid)};
+        const auto prewarmed{accept(tx, /*test_accept=*/true, /*scripts_prewarmed=*/false)};
+        const auto serial{accept(tx, /*test_accept=*/true, /*scripts_prewarmed=*/true)};
+        BOOST_CHECK_EQUAL(serial.m_result_type == MempoolAcceptResult::ResultType::VALID, !invalid);
+        check_same(prewarmed, serial);
+    }
+
+    // A package, prewarmed by MemPoolAccept, with a child failing its script
+    // checks.
+    const auto parent{create_tx({m_coinbase_txns[4], m_coinbase_txns[5]}, /*invalid=*/false)};
+    const auto child{create_tx({parent, m_coinbase_txns[6]}, /*invalid=*/true)};
+    const auto package_result{ProcessNewPackage(chainstate, *m_node.mempool, {parent, child}, /*test_accept=*/true, /*client_maxfeerate=*/{})};
+    BOOST_CHECK(package_result.m_state.IsInvalid());
+    BOOST_CHECK(package_result.m_tx_results.at(parent->GetWitnessHash()).m_result_type == MempoolAcceptResult::ResultType::VALID);
+
+    // The same transactions prewarmed by PrewarmSignatureCache, which is told
+    // to MemPoolAccept, and then submitted one by one.
+    PrewarmSignatureCache(chainstate, *m_node.mempool, std::vector{parent, child});
+    BOOST_CHECK(accept(parent, /*test_accept=*/false, /*scripts_prewarmed=*/true).m_result_type == MempoolAcceptResult::ResultType::VALID);
+    const auto child_serial{accept(child, /*test_accept=*/true, /*scripts_prewarmed=*/true)};
+    BOOST_CHECK(child_serial.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    check_same(package_result.m_tx_results.at(child->GetWitnessHash()), child_serial);
+    check_same(accept(child, /*test_accept=*/true, /*scripts_prewarmed=*/false), child_serial);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
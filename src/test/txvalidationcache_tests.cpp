@@ -24,7 +24,8 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
                        const CCoinsViewCache& inputs, unsigned int flags, bool cacheSigStore,
                        bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
                        ValidationCache& validation_cache,
-                       std::vector<CScriptCheck>* pvChecks) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+                       std::vector<CScriptCheck>* pvChecks,
+                       DeferredTxDataInit* txdata_init = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 BOOST_AUTO_TEST_SUITE(txvalidationcache_tests)
 
@@ -160,6 +161,23 @@ static void ValidateCheckInputsForAllFlags(const CTransaction &tx, uint32_t fail
             std::vector<CScriptCheck> scriptchecks;
             BOOST_CHECK(CheckInputScripts(tx, state, &active_coins_tip, test_flags, true, add_to_cache, txdata, validation_cache, &scriptchecks));
             BOOST_CHECK_EQUAL(scriptchecks.size(), tx.vin.size());
+
+            // Check that the script checks give the same result if they
+            // initialize the precomputed transaction data themselves.
+            if (count < 100) {
+                PrecomputedTransactionData deferred_txdata;
+                DeferredTxDataInit txdata_init;
+                std::vector<CScriptCheck> deferred_checks;
+                BOOST_CHECK(CheckInputScripts(tx, state, &active_coins_tip, test_flags, true, add_to_cache, deferred_txdata, validation_cache, &deferred_checks, &txdata_init));
+                BOOST_CHECK_EQUAL(deferred_checks.size(), tx.vin.size());
+                BOOST_CHECK(!deferred_txdata.m_spent_outputs_ready);
+                bool all_valid{true};
+                for (auto& check : deferred_checks) {
+                    all_valid &= !check().has_value();
+                }
+                BOOST_CHECK_EQUAL(all_valid, expected_return_value);
+                BOOST_CHECK(deferred_txdata.m_spent_outputs_ready);
+            }
         }
     }
 }
@@ -385,4 +403,46 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, Dersig100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(reorg_readd_prewarmed, TestChain100Setup)
+{
+    // Transactions of disconnected blocks have their scripts checked in
+    // batches before they are added back to the mempool. Children must find
+    // their parents from the same batch, and a transaction failing policy
+    // must still be rejected.
+    // Mature the coinbase outputs spent below, also once the blocks spending
+    // them are disconnected.
+    mineBlocks(3);
+    const CScript spk{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    const CTransactionRef parent{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, spk, 49 * COIN, /*submit=*/false))};
+    const CTransactionRef child{MakeTransactionRef(CreateValidMempoolTransaction(parent, 0, 101, coinbaseKey, spk, 48 * COIN, /*submit=*/false))};
+    const CTransactionRef other{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 2, coinbaseKey, spk, 49 * COIN, /*submit=*/false))};
+    // A non-push opcode in the scriptSig is valid by consensus but not standard.
+    CMutableTransaction mtx_nonstandard{CreateValidMempoolTransaction(m_coinbase_txns[2], 0, 3, coinbaseKey, spk, 49 * COIN, /*submit=*/false)};
+    mtx_nonstandard.vin[0].scriptSig = CScript() << OP_NOP << std::vector<unsigned char>(mtx_nonstandard.vin[0].scriptSig.begin() + 1, mtx_nonstandard.vin[0].scriptSig.end());
+    const CTransactionRef nonstandard{MakeTransactionRef(mtx_nonstandard)};
+
+    const CBlock block_parent{CreateAndProcessBlock({CMutableTransaction{*parent}}, spk)};
+    CreateAndProcessBlock({CMutableTransaction{*child}, CMutableTransaction{*nonstandard}, CMutableTransaction{*other}}, spk);
+    {
+        LOCK(cs_main);
+        BOOST_REQUIRE_EQUAL(m_node.chainman->ActiveChain().Height(), 105);
+        BOOST_REQUIRE_EQUAL(m_node.mempool->size(), 0U);
+    }
+
+    BlockValidationState state;
+    CBlockIndex* index_parent{WITH_LOCK(cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(block_parent.GetHash()))};
+    BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, index_parent));
+
+    LOCK2(cs_main, m_node.mempool->cs);
+    BOOST_CHECK_EQUAL(m_node.chainman->ActiveChain().Height(), 103);
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 3U);
+    BOOST_CHECK(m_node.mempool->exists(GenTxid::Txid(parent->GetHash())));
+    BOOST_CHECK(m_node.mempool->exists(GenTxid::Txid(child->GetHash())));
+    BOOST_CHECK(m_node.mempool->exists(GenTxid::Txid(other->GetHash())));
+    BOOST_CHECK(!m_node.mempool->exists(GenTxid::Txid(nonstandard->GetHash())));
+    const auto child_it{m_node.mempool->GetIter(child->GetHash())};
+    BOOST_REQUIRE(child_it);
+    BOOST_CHECK_EQUAL(child_it.value()->GetCountWithAncestors(), 2U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
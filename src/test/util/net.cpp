@@ -18,6 +18,7 @@
 
 #include <chrono>
 #include <optional>
+#include <string>
 #include <vector>
 
 void ConnmanTestMsg::Handshake(CNode& node,
@@ -91,6 +92,22 @@ void ConnmanTestMsg::FlushSendBuffer(CNode& node) const
     }
 }
 
+std::vector<std::string> ConnmanTestMsg::FlushSentMessageTypes(CNode& node) const
+{
+    std::vector<std::string> msg_types;
+    {
+        LOCK(node.cs_vSend);
+        // Without a socket, the first message is left in the transport.
+        const auto& [to_send, _more, msg_type] = node.m_transport->GetBytesToSend(false);
+        if (!to_send.empty()) msg_types.push_back(msg_type);
+        for (const CSerializedNetMsg& msg : node.vSendMsg) {
+            msg_types.push_back(msg.m_type);
+        }
+    }
+    FlushSendBuffer(node);
+    return msg_types;
+}
+
 bool ConnmanTestMsg::ReceiveMsgFrom(CNode& node, CSerializedNetMsg&& ser_msg) const
 {
     bool queued = node.m_transport->SetMessageToSend(ser_msg);
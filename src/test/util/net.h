@@ -45,6 +45,11 @@ struct ConnmanTestMsg : public CConnman {
         m_peer_connect_timeout = timeout;
     }
 
+    void SetMsgServeThreads(int threads)
+    {
+        m_msg_serve_threads = threads;
+    }
+
     std::vector<CNode*> TestNodes()
     {
         LOCK(m_nodes_mutex);
@@ -81,10 +86,17 @@ struct ConnmanTestMsg : public CConnman {
         return m_msgproc->ProcessMessages(&node, flagInterruptMsgProc);
     }
 
+    bool ServeMessagesOnce(CNode& node) EXCLUSIVE_LOCKS_REQUIRED(!NetEventsInterface::g_msgproc_mutex)
+    {
+        return m_msgproc->ServeMessages(&node, flagInterruptMsgProc);
+    }
+
     void NodeReceiveMsgBytes(CNode& node, Span<const uint8_t> msg_bytes, bool& complete) const;
 
     bool ReceiveMsgFrom(CNode& node, CSerializedNetMsg&& ser_msg) const;
     void FlushSendBuffer(CNode& node) const;
+    /** Return the types of the messages queued for sending to node, and drop them. */
+    std::vector<std::string> FlushSentMessageTypes(CNode& node) const;
 
     bool AlreadyConnectedPublic(const CAddress& addr) { return AlreadyConnectedToAddress(addr); };
 
@@ -11,12 +11,17 @@
 #include <primitives/transaction.h>
 #include <random.h>
 #include <serialize.h>
+#include <sync.h>
 #include <uint256.h>
+#include <util/threadnames.h>
 #include <util/vector.h>
 
 #include <cassert>
+#include <condition_variable>
 #include <cstdlib>
+#include <exception>
 #include <iterator>
+#include <thread>
 #include <utility>
 
 static constexpr uint8_t DB_COIN{'C'};
@@ -36,6 +41,88 @@ bool CCoinsViewDB::NeedsUpgrade()
 
 namespace {
 
+/**
+ * Commits the partial batches of one CCoinsViewDB::BatchWrite call on a
+ * dedicated thread, so that the next batch can be filled in the meantime.
+ * At most one batch is queued or being written at any time, which keeps the
+ * writes in order. The thread is only started once the first batch is handed
+ * over, so small flushes never start it.
+ */
+class BatchWriter
+{
+    CDBWrapper& m_db;
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! The batch waiting to be written or being written, if any.
+    CDBBatch* m_batch GUARDED_BY(m_mutex){nullptr};
+    //! The exception thrown by a failed write. No further batches are written after one.
+    std::exception_ptr m_error GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (true) {
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || m_batch; });
+            if (!m_batch) return;
+            CDBBatch& batch{*m_batch};
+            std::exception_ptr error;
+            {
+                REVERSE_LOCK(lock);
+                try {
+                    m_db.WriteBatch(batch);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            m_error = error;
+            m_batch = nullptr;
+            m_cv.notify_all();
+            if (m_error) return;
+        }
+    }
+
+public:
+    explicit BatchWriter(CDBWrapper& db) : m_db{db} {}
+
+    BatchWriter(const BatchWriter&) = delete;
+    BatchWriter& operator=(const BatchWriter&) = delete;
+
+    ~BatchWriter()
+    {
+        if (!m_thread.joinable()) return;
+        {
+            LOCK(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    /** Wait until the previous batch is written, then hand batch to the writer thread. */
+    void Write(CDBBatch& batch) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        Wait();
+        if (!m_thread.joinable()) {
+            m_thread = std::thread{[this] {
+                util::ThreadRename("coinswrite");
+                Loop();
+            }};
+        }
+        WITH_LOCK(m_mutex, m_batch = &batch);
+        m_cv.notify_all();
+    }
+
+    /** Wait until all batches handed over so far are written. Rethrows the error of a failed write. */
+    void Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_batch; });
+        if (m_error) std::rethrow_exception(m_error);
+    }
+};
+
 struct CoinEntry {
     COutPoint* outpoint;
     uint8_t key;
@@ -91,7 +178,17 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashBlock) {
-    CDBBatch batch(*m_db);
+    // Partial batches are committed to LevelDB on a writer thread while the
+    // next one is being filled, so that serializing the coins and writing them
+    // out overlap. At most one batch is in flight at any time, which keeps the
+    // writes ordered: the first batch marks the database as being in
+    // transition, and only the last one marks it as consistent again.
+    CDBBatch batch_a(*m_db);
+    CDBBatch batch_b(*m_db);
+    CDBBatch* batch{&batch_a};
+    // Declared after the batches, so that it is destroyed (and waits for the
+    // write to finish) before the batch it refers to.
+    BatchWriter writer{*m_db};
     size_t count = 0;
     size_t changed = 0;
     assert(!hashBlock.IsNull());
@@ -113,40 +210,45 @@ bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashB
     // transition from old_tip to hashBlock.
     // A vector is used for future extensibility, as we may want to support
     // interrupting after partial writes from multiple independent reorgs.
-    batch.Erase(DB_BEST_BLOCK);
-    batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
+    batch->Erase(DB_BEST_BLOCK);
+    batch->Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
 
     for (auto it{cursor.Begin()}; it != cursor.End();) {
         if (it->second.IsDirty()) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent())
-                batch.Erase(entry);
+                batch->Erase(entry);
             else
-                batch.Write(entry, it->second.coin);
+                batch->Write(entry, it->second.coin);
             changed++;
         }
         count++;
         it = cursor.NextAndMaybeErase(*it);
-        if (batch.SizeEstimate() > m_options.batch_write_bytes) {
-            LogDebug(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-            m_db->WriteBatch(batch);
-            batch.Clear();
+        if (batch->SizeEstimate() > m_options.batch_write_bytes) {
+            LogDebug(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch->SizeEstimate() * (1.0 / 1048576.0));
+            writer.Write(*batch);
             if (m_options.simulate_crash_ratio) {
+                // Only crash once this batch is on disk, so that every
+                // simulated crash leaves a partially flushed database behind.
+                writer.Wait();
                 static FastRandomContext rng;
                 if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
                     LogPrintf("Simulating a crash. Goodbye.\n");
                     _Exit(0);
                 }
             }
+            batch = batch == &batch_a ? &batch_b : &batch_a;
+            batch->Clear();
         }
     }
 
     // In the last batch, mark the database as consistent with hashBlock again.
-    batch.Erase(DB_HEAD_BLOCKS);
-    batch.Write(DB_BEST_BLOCK, hashBlock);
+    batch->Erase(DB_HEAD_BLOCKS);
+    batch->Write(DB_BEST_BLOCK, hashBlock);
 
-    LogDebug(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-    bool ret = m_db->WriteBatch(batch);
+    writer.Wait();
+    LogDebug(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch->SizeEstimate() * (1.0 / 1048576.0));
+    bool ret = m_db->WriteBatch(*batch);
     LogDebug(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
     return ret;
 }
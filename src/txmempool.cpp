@@ -54,8 +54,28 @@ bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
     return true;
 }
 
+/** Memory used by mapTx for each entry. Estimated as an allocation holding the
+ *  entry and 15 pointers, as no exact formula for boost::multi_index_contained
+ *  is implemented. */
+static size_t EntryOverheadUsage()
+{
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*));
+}
+
+/** Memory used by txns_randomized with the given capacity. */
+static size_t RandomizedUsage(size_t capacity)
+{
+    return memusage::MallocUsage(capacity * sizeof(decltype(CTxMemPool::txns_randomized)::value_type));
+}
+
+/** Whether txns_randomized is shrunk to fit after a removal leaves size elements. */
+static bool ShouldShrinkRandomized(size_t size, size_t capacity)
+{
+    return size * 2 < capacity;
+}
+
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
-                                      const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove)
+                                      const std::set<uint256>& setExclude, ancestorDeltaMap& ancestor_deltas)
 {
     CTxMemPoolEntry::Children stageEntries, descendants;
     stageEntries = updateIt->GetMemPoolChildrenConst();
@@ -90,16 +110,13 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendan
             modifyFee += descendant.GetModifiedFee();
             modifyCount++;
             cachedDescendants[updateIt].insert(mapTx.iterator_to(descendant));
-            // Update ancestor state for each descendant
-            mapTx.modify(mapTx.iterator_to(descendant), [=](CTxMemPoolEntry& e) {
-              e.UpdateAncestorState(updateIt->GetTxSize(), updateIt->GetModifiedFee(), 1, updateIt->GetSigOpCost());
-            });
-            // Don't directly remove the transaction here -- doing so would
-            // invalidate iterators in cachedDescendants. Mark it for removal
-            // by inserting into descendants_to_remove.
-            if (descendant.GetCountWithAncestors() > uint64_t(m_opts.limits.ancestor_count) || descendant.GetSizeWithAncestors() > m_opts.limits.ancestor_size_vbytes) {
-                descendants_to_remove.insert(descendant.GetTx().GetHash());
-            }
+            // Update ancestor state for each descendant. This is applied by the
+            // caller once all transactions have been processed.
+            AncestorStateDelta& delta{ancestor_deltas[mapTx.iterator_to(descendant)]};
+            delta.size += updateIt->GetTxSize();
+            delta.fee = SaturatingAdd(delta.fee, updateIt->GetModifiedFee());
+            ++delta.count;
+            delta.sigops += updateIt->GetSigOpCost();
         }
     }
     mapTx.modify(updateIt, [=](CTxMemPoolEntry& e) { e.UpdateDescendantState(modifySize, modifyFee, modifyCount); });
@@ -117,7 +134,7 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
     // accounted for in the state of their ancestors)
     std::set<uint256> setAlreadyIncluded(vHashesToUpdate.begin(), vHashesToUpdate.end());
 
-    std::set<uint256> descendants_to_remove;
+    ancestorDeltaMap ancestor_deltas;
 
     // Iterate in reverse, so that whenever we are looking at a transaction
     // we are sure that all in-mempool descendants have already been processed.
@@ -148,7 +165,22 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
                 }
             }
         } // release epoch guard for UpdateForDescendants
-        UpdateForDescendants(it, mapMemPoolDescendantsToUpdate, setAlreadyIncluded, descendants_to_remove);
+        UpdateForDescendants(it, mapMemPoolDescendantsToUpdate, setAlreadyIncluded, ancestor_deltas);
+    }
+
+    // Ancestor state only grows here, so an entry exceeds the ancestor limits
+    // after all updates iff it did after any of them.
+    std::set<uint256> descendants_to_remove;
+    for (const auto& [descendant_it, delta] : ancestor_deltas) {
+        mapTx.modify(descendant_it, [&delta](CTxMemPoolEntry& e) {
+            e.UpdateAncestorState(delta.size, delta.fee, delta.count, delta.sigops);
+        });
+        // Don't directly remove the transaction here -- doing so would
+        // invalidate iterators in ancestor_deltas. Mark it for removal
+        // by inserting into descendants_to_remove.
+        if (descendant_it->GetCountWithAncestors() > uint64_t(m_opts.limits.ancestor_count) || descendant_it->GetSizeWithAncestors() > m_opts.limits.ancestor_size_vbytes) {
+            descendants_to_remove.insert(descendant_it->GetTx().GetHash());
+        }
     }
 
     for (const auto& txid : descendants_to_remove) {
@@ -507,7 +539,7 @@ void CTxMemPool::addNewTransaction(CTxMemPool::txiter newit, CTxMemPool::setEntr
     totalTxSize += entry.GetTxSize();
     m_total_fee += entry.GetFee();
 
-    txns_randomized.emplace_back(newit->GetSharedTx());
+    txns_randomized.emplace_back(newit->GetTx().GetWitnessHash(), newit->GetSharedTx());
     newit->idx_randomized = txns_randomized.size() - 1;
 
     TRACEPOINT(mempool, added,
@@ -545,11 +577,11 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 
     if (txns_randomized.size() > 1) {
         // Update idx_randomized of the to-be-moved entry.
-        Assert(GetEntry(txns_randomized.back()->GetHash()))->idx_randomized = it->idx_randomized;
+        Assert(GetEntry(txns_randomized.back().second->GetHash()))->idx_randomized = it->idx_randomized;
         // Remove entry from txns_randomized by replacing it with the back and deleting the back.
         txns_randomized[it->idx_randomized] = std::move(txns_randomized.back());
         txns_randomized.pop_back();
-        if (txns_randomized.size() * 2 < txns_randomized.capacity())
+        if (ShouldShrinkRandomized(txns_randomized.size(), txns_randomized.capacity()))
             txns_randomized.shrink_to_fit();
     } else
         txns_randomized.clear();
@@ -1062,8 +1094,7 @@ void CCoinsViewMemPool::Reset()
 
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
-    // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + cachedInnerUsage;
+    return EntryOverheadUsage() * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + RandomizedUsage(txns_randomized.capacity()) + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1161,20 +1192,65 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
 
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
-    while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
-
-        // We set the new mempool min fee to the feerate of the removed set, plus the
-        // "minimum reasonable fee rate" (ie some value under which we consider txn
-        // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
-        // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
-        removed += m_opts.incremental_relay_feerate;
-        trackPackageRemoved(removed);
-        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
-
+    size_t usage{DynamicMemoryUsage()};
+    while (!mapTx.empty() && usage > sizelimit) {
+        // Evict packages in descendant score order, but stage as many of them
+        // as possible before removing anything. A package that has no
+        // ancestors outside of itself can be removed without changing the
+        // descendant state (and therefore the score) of any remaining entry,
+        // so the following package is the same one that would be picked after
+        // actually removing it. The batch ends after the first package that is
+        // not self-contained, or once removing the packages staged so far may
+        // bring usage down to sizelimit. The latter uses an upper bound of the
+        // memory freed by each package, so no more is evicted than by removing
+        // one package at a time.
+        const size_t max_to_free{usage - sizelimit};
+        size_t max_freed{0};
+        const size_t next_tx_usage{mapNextTx.empty() ? 0 : memusage::DynamicUsage(mapNextTx) / mapNextTx.size()};
+        size_t randomized_size{txns_randomized.size()};
+        size_t randomized_capacity{txns_randomized.capacity()};
         setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
+        auto& index{mapTx.get<descendant_score>()};
+        for (auto it{index.begin()}; it != index.end() && max_freed < max_to_free; ++it) {
+            const txiter package_root{mapTx.project<0>(it)};
+            // Descendants of packages staged earlier in this batch.
+            if (stage.contains(package_root)) continue;
+
+            setEntries package;
+            CalculateDescendants(package_root, package);
+            const bool self_contained{std::ranges::all_of(package, [&](txiter member) {
+                return std::ranges::all_of(member->GetMemPoolParentsConst(), [&](const CTxMemPoolEntry& parent) {
+                    return package.contains(mapTx.iterator_to(parent));
+                });
+            })};
+            if (!self_contained && !stage.empty()) break;
+
+            // We set the new mempool min fee to the feerate of the removed set, plus the
+            // "minimum reasonable fee rate" (ie some value under which we consider txn
+            // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
+            // equal to txn which were removed with no block in between.
+            CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+            removed += m_opts.incremental_relay_feerate;
+            trackPackageRemoved(removed);
+            maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
+
+            const size_t randomized_usage_before{RandomizedUsage(randomized_capacity)};
+            for (txiter member : package) {
+                max_freed += EntryOverheadUsage() + member->DynamicMemoryUsage() + next_tx_usage * member->GetTx().vin.size() +
+                             memusage::DynamicUsage(member->GetMemPoolParentsConst()) + memusage::DynamicUsage(member->GetMemPoolChildrenConst());
+                // Mirror how removeUnchecked shrinks txns_randomized.
+                if (randomized_size > 1) {
+                    --randomized_size;
+                    if (ShouldShrinkRandomized(randomized_size, randomized_capacity)) randomized_capacity = randomized_size;
+                } else {
+                    randomized_size = 0;
+                }
+            }
+            max_freed += randomized_usage_before - RandomizedUsage(randomized_capacity);
+            stage.insert(package.begin(), package.end());
+
+            if (!self_contained) break;
+        }
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1192,6 +1268,7 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
                 }
             }
         }
+        usage = DynamicMemoryUsage();
     }
 
     if (maxFeeRateRemoved > CFeeRate(0)) {
@@ -391,7 +391,10 @@ public:
     indexed_transaction_set mapTx GUARDED_BY(cs);
 
     using txiter = indexed_transaction_set::nth_index<0>::type::const_iterator;
-    std::vector<CTransactionRef> txns_randomized GUARDED_BY(cs); //!< All transactions in mapTx, in random order
+    /** All transactions in mapTx, in random order. The wtxid is stored next to each
+     *  transaction so that compact block reconstruction can scan the whole mempool
+     *  without dereferencing every transaction. */
+    std::vector<std::pair<Wtxid, CTransactionRef>> txns_randomized GUARDED_BY(cs);
 
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
 
@@ -401,6 +404,17 @@ public:
 private:
     typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
 
+    /** Pending change to the ancestor state of an entry. Accumulating these lets
+     *  each entry be modified (and so re-sorted in mapTx) only once, however many
+     *  of its ancestors are updated. */
+    struct AncestorStateDelta {
+        int32_t size{0};
+        CAmount fee{0};
+        int64_t count{0};
+        int64_t sigops{0};
+    };
+    typedef std::map<txiter, AncestorStateDelta, CompareIteratorByHash> ancestorDeltaMap;
+
 
     void UpdateParent(txiter entry, txiter parent, bool add) EXCLUSIVE_LOCKS_REQUIRED(cs);
     void UpdateChild(txiter entry, txiter child, bool add) EXCLUSIVE_LOCKS_REQUIRED(cs);
@@ -733,8 +747,8 @@ private:
      *      be removed for violation of ancestor limits.
      * @post if updateIt has any non-excluded descendants, cachedDescendants has
      *       a new cache line for updateIt.
-     * @post descendants_to_remove has a new entry for any descendant which exceeded
-     *       ancestor limits relative to updateIt.
+     * @post ancestor_deltas includes updateIt in the ancestor state of each of
+     *       its non-excluded descendants.
      *
      * @param[in] updateIt the entry to update for its descendants
      * @param[in,out] cachedDescendants a cache where each line corresponds to all
@@ -745,12 +759,12 @@ private:
      *     that must not be accounted for (because any descendants in setExclude
      *     were added to the mempool after the transaction being updated and hence
      *     their state is already reflected in the parent state).
-     * @param[out] descendants_to_remove Populated with the txids of entries that
-     *     exceed ancestor limits. It's the responsibility of the caller to
-     *     removeRecursive them.
+     * @param[in,out] ancestor_deltas Changes to the ancestor state of
+     *     descendants. It's the responsibility of the caller to apply them and
+     *     removeRecursive any entry that then exceeds ancestor limits.
      */
     void UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
-                              const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove) EXCLUSIVE_LOCKS_REQUIRED(cs);
+                              const std::set<uint256>& setExclude, ancestorDeltaMap& ancestor_deltas) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Update ancestors of hash to add/remove it as a descendant transaction. */
     void UpdateAncestorsOf(bool add, txiter hash, setEntries &setAncestors) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Set ancestor state for an entry */
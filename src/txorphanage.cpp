@@ -10,9 +10,10 @@
 #include <primitives/transaction.h>
 #include <util/time.h>
 
+#include <algorithm>
 #include <cassert>
 
-bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer)
+bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer, std::span<const Txid> missing_parents)
 {
     const Txid& hash = tx->GetHash();
     const Wtxid& wtxid = tx->GetWitnessHash();
@@ -36,19 +37,27 @@ bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer)
         return false;
     }
 
-    auto ret = m_orphans.emplace(wtxid, OrphanTx{{tx, {peer}, Now<NodeSeconds>() + ORPHAN_TX_EXPIRE_TIME}, m_orphan_list.size()});
+    auto ret = m_orphans.emplace(wtxid, OrphanTx{{tx, {peer}, Now<NodeSeconds>() + ORPHAN_TX_EXPIRE_TIME}, m_orphan_list.size(), {}});
     assert(ret.second);
     m_orphan_list.push_back(ret.first);
     for (const CTxIn& txin : tx->vin) {
-        m_outpoint_to_orphan_it[txin.prevout].insert(ret.first);
+        m_parent_to_orphan_it[txin.prevout.hash].insert(ret.first);
+    }
+    auto& orphan_missing_parents{ret.first->second.missing_parents};
+    for (const Txid& parent_txid : missing_parents) {
+        const auto parent_it{m_parent_to_orphan_it.find(parent_txid)};
+        if (parent_it != m_parent_to_orphan_it.end() && parent_it->second.contains(ret.first) &&
+            std::find(orphan_missing_parents.begin(), orphan_missing_parents.end(), parent_txid) == orphan_missing_parents.end()) {
+            orphan_missing_parents.push_back(parent_txid);
+        }
     }
     m_total_orphan_usage += sz;
     m_total_announcements += 1;
     auto& peer_info = m_peer_orphanage_info.try_emplace(peer).first->second;
     peer_info.m_total_usage += sz;
 
-    LogDebug(BCLog::TXPACKAGES, "stored orphan tx %s (wtxid=%s), weight: %u (mapsz %u outsz %u)\n", hash.ToString(), wtxid.ToString(), sz,
-             m_orphans.size(), m_outpoint_to_orphan_it.size());
+    LogDebug(BCLog::TXPACKAGES, "stored orphan tx %s (wtxid=%s), weight: %u (mapsz %u parentsz %u)\n", hash.ToString(), wtxid.ToString(), sz,
+             m_orphans.size(), m_parent_to_orphan_it.size());
     return true;
 }
 
@@ -76,12 +85,12 @@ int TxOrphanage::EraseTx(const Wtxid& wtxid)
         return 0;
     for (const CTxIn& txin : it->second.tx->vin)
     {
-        auto itPrev = m_outpoint_to_orphan_it.find(txin.prevout);
-        if (itPrev == m_outpoint_to_orphan_it.end())
+        auto itPrev = m_parent_to_orphan_it.find(txin.prevout.hash);
+        if (itPrev == m_parent_to_orphan_it.end())
             continue;
         itPrev->second.erase(it);
         if (itPrev->second.empty())
-            m_outpoint_to_orphan_it.erase(itPrev);
+            m_parent_to_orphan_it.erase(itPrev);
     }
 
     const auto tx_size{it->second.GetUsage()};
@@ -172,34 +181,46 @@ void TxOrphanage::LimitOrphans(unsigned int max_orphans, FastRandomContext& rng)
     if (nEvicted > 0) LogDebug(BCLog::TXPACKAGES, "orphanage overflow, removed %u tx\n", nEvicted);
 }
 
-void TxOrphanage::AddChildrenToWorkSet(const CTransaction& tx, FastRandomContext& rng)
+void TxOrphanage::AddChildrenToWorkSet(const CTransaction& tx, FastRandomContext& rng, const std::function<bool(const Txid&)>& have_parent)
 {
-    for (unsigned int i = 0; i < tx.vout.size(); i++) {
-        const auto it_by_prev = m_outpoint_to_orphan_it.find(COutPoint(tx.GetHash(), i));
-        if (it_by_prev != m_outpoint_to_orphan_it.end()) {
-            for (const auto& elem : it_by_prev->second) {
-                // Belt and suspenders, each orphan should always have at least 1 announcer.
-                if (!Assume(!elem->second.announcers.empty())) continue;
-
-                // Select a random peer to assign orphan processing, reducing wasted work if the orphan is still missing
-                // inputs. However, we don't want to create an issue in which the assigned peer can purposefully stop us
-                // from processing the orphan by disconnecting.
-                auto announcer_iter = std::begin(elem->second.announcers);
-                std::advance(announcer_iter, rng.randrange(elem->second.announcers.size()));
-                auto announcer = *(announcer_iter);
-
-                // Get this source peer's work set, emplacing an empty set if it didn't exist
-                // (note: if this peer wasn't still connected, we would have removed the orphan tx already)
-                std::set<Wtxid>& orphan_work_set = m_peer_orphanage_info.try_emplace(announcer).first->second.m_work_set;
-                // Add this tx to the work set
-                orphan_work_set.insert(elem->first);
-                LogDebug(BCLog::TXPACKAGES, "added %s (wtxid=%s) to peer %d workset\n",
-                         tx.GetHash().ToString(), tx.GetWitnessHash().ToString(), announcer);
-            }
-        }
+    const auto it_by_parent = m_parent_to_orphan_it.find(tx.GetHash());
+    if (it_by_parent == m_parent_to_orphan_it.end()) return;
+    for (const auto& elem : it_by_parent->second) {
+        // Belt and suspenders, each orphan should always have at least 1 announcer.
+        if (!Assume(!elem->second.announcers.empty())) continue;
+
+        // Don't reconsider the orphan until its last missing parent has arrived, as it would only
+        // fail again for missing inputs.
+        if (!ResolveMissingParent(elem->second, tx.GetHash(), have_parent)) continue;
+
+        // Select a random peer to assign orphan processing, reducing wasted work if the orphan is still missing
+        // inputs. However, we don't want to create an issue in which the assigned peer can purposefully stop us
+        // from processing the orphan by disconnecting.
+        auto announcer_iter = std::begin(elem->second.announcers);
+        std::advance(announcer_iter, rng.randrange(elem->second.announcers.size()));
+        auto announcer = *(announcer_iter);
+
+        // Get this source peer's work set, emplacing an empty set if it didn't exist
+        // (note: if this peer wasn't still connected, we would have removed the orphan tx already)
+        std::set<Wtxid>& orphan_work_set = m_peer_orphanage_info.try_emplace(announcer).first->second.m_work_set;
+        // Add this tx to the work set
+        orphan_work_set.insert(elem->first);
+        LogDebug(BCLog::TXPACKAGES, "added %s (wtxid=%s) to peer %d workset\n",
+                 tx.GetHash().ToString(), tx.GetWitnessHash().ToString(), announcer);
     }
 }
 
+bool TxOrphanage::ResolveMissingParent(OrphanTx& orphan, const Txid& parent_txid, const std::function<bool(const Txid&)>& have_parent)
+{
+    auto& missing_parents{orphan.missing_parents};
+    // Without information about missing parents, every parent may be the last one.
+    if (missing_parents.empty()) return true;
+    std::erase(missing_parents, parent_txid);
+    // Parents may also have arrived without being passed to AddChildrenToWorkSet (e.g. through RPC).
+    if (have_parent) std::erase_if(missing_parents, have_parent);
+    return missing_parents.empty();
+}
+
 bool TxOrphanage::HaveTx(const Wtxid& wtxid) const
 {
     return m_orphans.count(wtxid);
@@ -253,11 +274,20 @@ void TxOrphanage::EraseForBlock(const CBlock& block)
 
         // Which orphan pool entries must we evict?
         for (const auto& txin : tx.vin) {
-            auto itByPrev = m_outpoint_to_orphan_it.find(txin.prevout);
-            if (itByPrev == m_outpoint_to_orphan_it.end()) continue;
+            auto itByPrev = m_parent_to_orphan_it.find(txin.prevout.hash);
+            if (itByPrev == m_parent_to_orphan_it.end()) continue;
             for (auto mi = itByPrev->second.begin(); mi != itByPrev->second.end(); ++mi) {
                 const CTransaction& orphanTx = *(*mi)->second.tx;
-                vOrphanErase.push_back(orphanTx.GetWitnessHash());
+                if (std::ranges::any_of(orphanTx.vin, [&](const CTxIn& orphan_txin) { return orphan_txin.prevout == txin.prevout; })) {
+                    vOrphanErase.push_back(orphanTx.GetWitnessHash());
+                }
+            }
+        }
+
+        // A parent that is confirmed is no longer missing.
+        if (auto it_by_parent = m_parent_to_orphan_it.find(tx.GetHash()); it_by_parent != m_parent_to_orphan_it.end()) {
+            for (const auto& elem : it_by_parent->second) {
+                ResolveMissingParent(elem->second, tx.GetHash(), /*have_parent=*/{});
             }
         }
     }
@@ -278,14 +308,12 @@ std::vector<CTransactionRef> TxOrphanage::GetChildrenFromSamePeer(const CTransac
     // and so we can sort by nTimeExpire.
     std::vector<OrphanMap::iterator> iters;
 
-    // For each output, get all entries spending this prevout, filtering for ones from the specified peer.
-    for (unsigned int i = 0; i < parent->vout.size(); i++) {
-        const auto it_by_prev = m_outpoint_to_orphan_it.find(COutPoint(parent->GetHash(), i));
-        if (it_by_prev != m_outpoint_to_orphan_it.end()) {
-            for (const auto& elem : it_by_prev->second) {
-                if (elem->second.announcers.contains(nodeid)) {
-                    iters.emplace_back(elem);
-                }
+    // Get all entries spending an output of parent, filtering for ones from the specified peer.
+    const auto it_by_parent = m_parent_to_orphan_it.find(parent->GetHash());
+    if (it_by_parent != m_parent_to_orphan_it.end()) {
+        for (const auto& elem : it_by_parent->second) {
+            if (elem->second.announcers.contains(nodeid)) {
+                iters.emplace_back(elem);
             }
         }
     }
@@ -10,10 +10,15 @@
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <sync.h>
+#include <util/hasher.h>
 #include <util/time.h>
 
+#include <functional>
 #include <map>
 #include <set>
+#include <span>
+#include <unordered_map>
+#include <vector>
 
 /** Expiration time for orphan transactions */
 static constexpr auto ORPHAN_TX_EXPIRE_TIME{20min};
@@ -28,8 +33,10 @@ static constexpr auto ORPHAN_TX_EXPIRE_INTERVAL{5min};
  */
 class TxOrphanage {
 public:
-    /** Add a new orphan transaction */
-    bool AddTx(const CTransactionRef& tx, NodeId peer);
+    /** Add a new orphan transaction. missing_parents are the txids of its parents that are known to
+     *  be missing. If given, the orphan is only added to a work set once all of them have been
+     *  passed to AddChildrenToWorkSet (or confirmed in a block), rather than on every parent. */
+    bool AddTx(const CTransactionRef& tx, NodeId peer, std::span<const Txid> missing_parents = {});
 
     /** Add an additional announcer to an orphan if it exists. Otherwise, do nothing. */
     bool AddAnnouncer(const Wtxid& wtxid, NodeId peer);
@@ -62,8 +69,10 @@ public:
     /** Limit the orphanage to the given maximum */
     void LimitOrphans(unsigned int max_orphans, FastRandomContext& rng);
 
-    /** Add any orphans that list a particular tx as a parent into the from peer's work set */
-    void AddChildrenToWorkSet(const CTransaction& tx, FastRandomContext& rng);
+    /** Add any orphans that list a particular tx as a parent, and are not waiting for other missing
+     *  parents, into the from peer's work set. If given, have_parent is used to check whether the
+     *  other missing parents have arrived in the meantime. */
+    void AddChildrenToWorkSet(const CTransaction& tx, FastRandomContext& rng, const std::function<bool(const Txid&)>& have_parent = {});
 
     /** Does this peer have any work to do? */
     bool HaveTxToReconsider(NodeId peer);
@@ -112,6 +121,8 @@ public:
 protected:
     struct OrphanTx : public OrphanTxBase {
         size_t list_pos;
+        /** Parents that were missing when this orphan was added and have not arrived since. */
+        std::vector<Txid> missing_parents;
     };
 
     /** Total usage (weight) of all entries in m_orphans. */
@@ -152,13 +163,18 @@ protected:
         }
     };
 
-    /** Index from the parents' COutPoint into the m_orphans. Used
-     *  to remove orphan transactions from the m_orphans */
-    std::map<COutPoint, std::set<OrphanMap::iterator, IteratorComparator>> m_outpoint_to_orphan_it;
+    /** Index from the parents' txid into the m_orphans. Used to find the
+     *  orphans to reconsider when a parent arrives, and to remove orphan
+     *  transactions from the m_orphans */
+    std::unordered_map<Txid, std::set<OrphanMap::iterator, IteratorComparator>, SaltedTxidHasher> m_parent_to_orphan_it;
 
     /** Orphan transactions in vector for quick random eviction */
     std::vector<OrphanMap::iterator> m_orphan_list;
 
+    /** Remove parent_txid (and, if given, any other parents for which have_parent returns true) from
+     *  the orphan's missing parents. Returns whether the orphan is not waiting for other parents. */
+    static bool ResolveMissingParent(OrphanTx& orphan, const Txid& parent_txid, const std::function<bool(const Txid&)>& have_parent);
+
     /** Timestamp for the next scheduled sweep of expired orphans */
     NodeSeconds m_next_sweep{0s};
 };
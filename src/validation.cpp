@@ -84,7 +84,6 @@ using kernel::Notifications;
 using fsbridge::FopenFn;
 using node::BlockManager;
 using node::BlockMap;
-using node::CBlockIndexHeightOnlyComparator;
 using node::CBlockIndexWorkComparator;
 using node::SnapshotMetadata;
 
@@ -96,6 +95,8 @@ static constexpr std::chrono::hours DATABASE_WRITE_INTERVAL{1};
 static constexpr std::chrono::hours DATABASE_FLUSH_INTERVAL{24};
 /** Maximum age of our tip for us to be considered current for fee estimation */
 static constexpr std::chrono::hours MAX_FEE_ESTIMATION_TIP_AGE{3};
+/** Number of disconnected transactions whose scripts are checked together when re-adding them to the mempool. */
+static constexpr size_t REORG_PREWARM_BATCH_SIZE{1000};
 const std::vector<std::string> CHECKLEVEL_DOC {
     "level 0 reads the blocks from disk",
     "level 1 verifies block validity",
@@ -140,7 +141,8 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
                        const CCoinsViewCache& inputs, unsigned int flags, bool cacheSigStore,
                        bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
                        ValidationCache& validation_cache,
-                       std::vector<CScriptCheck>* pvChecks = nullptr)
+                       std::vector<CScriptCheck>* pvChecks = nullptr,
+                       DeferredTxDataInit* txdata_init = nullptr)
                        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 bool CheckFinalTxAtTip(const CBlockIndex& active_chain_tip, const CTransaction& tx)
@@ -310,19 +312,32 @@ void Chainstate::MaybeUpdateMempoolForReorg(
         // been previously seen in a block.
         const auto queuedTx = disconnectpool.take();
         auto it = queuedTx.rbegin();
+        std::vector<CTransactionRef> batch;
         while (it != queuedTx.rend()) {
-            // ignore validation errors in resurrected transactions
-            if (!fAddToMempool || (*it)->IsCoinBase() ||
-                AcceptToMemoryPool(*this, *it, GetTime(),
-                    /*bypass_limits=*/true, /*test_accept=*/false).m_result_type !=
-                        MempoolAcceptResult::ResultType::VALID) {
-                // If the transaction doesn't make it in to the mempool, remove any
-                // transactions that depend on it (which would now be orphans).
-                m_mempool->removeRecursive(**it, MemPoolRemovalReason::REORG);
-            } else if (m_mempool->exists(GenTxid::Txid((*it)->GetHash()))) {
-                vHashUpdate.push_back((*it)->GetHash());
+            // Verify the scripts of the next batch of transactions in parallel
+            // first, so that AcceptToMemoryPool mostly hits the signature cache.
+            // Batches are in topological order, so parents are either in the
+            // same batch or already back in the mempool.
+            auto batch_end{it};
+            batch.clear();
+            while (batch_end != queuedTx.rend() && batch.size() < REORG_PREWARM_BATCH_SIZE) {
+                batch.push_back(*batch_end++);
+            }
+            if (fAddToMempool) PrewarmSignatureCache(*this, *m_mempool, batch);
+
+            for (; it != batch_end; ++it) {
+                // ignore validation errors in resurrected transactions
+                if (!fAddToMempool || (*it)->IsCoinBase() ||
+                    AcceptToMemoryPool(*this, *it, GetTime(),
+                        /*bypass_limits=*/true, /*test_accept=*/false, /*scripts_prewarmed=*/true).m_result_type !=
+                            MempoolAcceptResult::ResultType::VALID) {
+                    // If the transaction doesn't make it in to the mempool, remove any
+                    // transactions that depend on it (which would now be orphans).
+                    m_mempool->removeRecursive(**it, MemPoolRemovalReason::REORG);
+                } else if (m_mempool->exists(GenTxid::Txid((*it)->GetHash()))) {
+                    vHashUpdate.push_back((*it)->GetHash());
+                }
             }
-            ++it;
         }
     }
 
@@ -485,10 +500,14 @@ public:
         /** Whether CPFP carveout and RBF carveout are granted. */
         const bool m_allow_carveouts;
 
+        /** When true, the caller already checked the scripts on the script check threads to fill
+         * the signature cache, so PrewarmScriptChecks() is skipped. */
+        const bool m_scripts_prewarmed;
+
         /** Parameters for single transaction mempool validation. */
         static ATMPArgs SingleAccept(const CChainParams& chainparams, int64_t accept_time,
                                      bool bypass_limits, std::vector<COutPoint>& coins_to_uncache,
-                                     bool test_accept) {
+                                     bool test_accept, bool scripts_prewarmed) {
             return ATMPArgs{/* m_chainparams */ chainparams,
                             /* m_accept_time */ accept_time,
                             /* m_bypass_limits */ bypass_limits,
@@ -500,6 +519,7 @@ public:
                             /* m_package_feerates */ false,
                             /* m_client_maxfeerate */ {}, // checked by caller
                             /* m_allow_carveouts */ true,
+                            /* m_scripts_prewarmed */ scripts_prewarmed,
             };
         }
 
@@ -517,6 +537,7 @@ public:
                             /* m_package_feerates */ false,
                             /* m_client_maxfeerate */ {}, // checked by caller
                             /* m_allow_carveouts */ false,
+                            /* m_scripts_prewarmed */ false,
             };
         }
 
@@ -534,6 +555,7 @@ public:
                             /* m_package_feerates */ true,
                             /* m_client_maxfeerate */ client_maxfeerate,
                             /* m_allow_carveouts */ false,
+                            /* m_scripts_prewarmed */ false,
             };
         }
 
@@ -550,6 +572,7 @@ public:
                             /* m_package_feerates */ false, // only 1 transaction
                             /* m_client_maxfeerate */ package_args.m_client_maxfeerate,
                             /* m_allow_carveouts */ false,
+                            /* m_scripts_prewarmed */ package_args.m_scripts_prewarmed,
             };
         }
 
@@ -566,7 +589,8 @@ public:
                  bool package_submission,
                  bool package_feerates,
                  std::optional<CFeeRate> client_maxfeerate,
-                 bool allow_carveouts)
+                 bool allow_carveouts,
+                 bool scripts_prewarmed)
             : m_chainparams{chainparams},
               m_accept_time{accept_time},
               m_bypass_limits{bypass_limits},
@@ -577,7 +601,8 @@ public:
               m_package_submission{package_submission},
               m_package_feerates{package_feerates},
               m_client_maxfeerate{client_maxfeerate},
-              m_allow_carveouts{allow_carveouts}
+              m_allow_carveouts{allow_carveouts},
+              m_scripts_prewarmed{scripts_prewarmed}
         {
             // If we are using package feerates, we must be doing package submission.
             // It also means carveouts and sibling eviction are not permitted.
@@ -683,6 +708,12 @@ private:
     // only invoke this on transactions that have otherwise passed policy checks.
     bool PolicyScriptChecks(const ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Verify the input scripts of the given transactions on the script check
+    // worker threads, so that the signatures are in the signature cache by the
+    // time PolicyScriptChecks() checks them serially. The result is ignored;
+    // PolicyScriptChecks() still determines acceptance and the reject reason.
+    void PrewarmScriptChecks(std::span<Workspace> workspaces) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Re-run the script checks, using consensus flags, and try to cache the
     // result in the scriptcache. This should be done after
     // PolicyScriptChecks(). This requires that all inputs either be in our
@@ -1252,6 +1283,32 @@ bool MemPoolAccept::PolicyScriptChecks(const ATMPArgs& args, Workspace& ws)
     return true;
 }
 
+void MemPoolAccept::PrewarmScriptChecks(std::span<Workspace> workspaces)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    auto& check_queue{m_active_chainstate.m_chainman.GetCheckQueue()};
+    if (!check_queue.HasThreads()) return;
+    size_t num_inputs{0};
+    for (const Workspace& ws : workspaces) {
+        num_inputs += ws.m_ptx->vin.size();
+    }
+    // A single input is verified faster than it is handed to another thread.
+    if (num_inputs < 2) return;
+
+    std::vector<CScriptCheck> checks;
+    checks.reserve(num_inputs);
+    for (Workspace& ws : workspaces) {
+        TxValidationState state_dummy;
+        CheckInputScripts(*ws.m_ptx, state_dummy, m_view, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheSigStore=*/true,
+                          /*cacheFullScriptStore=*/false, ws.m_precomputed_txdata, GetValidationCache(), &checks);
+    }
+    CCheckQueueControl<CScriptCheck> control(&check_queue);
+    control.Add(std::move(checks));
+    (void)control.Complete();
+}
+
 bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws)
 {
     AssertLockHeld(cs_main);
@@ -1454,6 +1511,7 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
 
     // Perform the inexpensive checks first and avoid hashing and signature verification unless
     // those checks pass, to mitigate CPU exhaustion denial-of-service attacks.
+    if (!args.m_scripts_prewarmed) PrewarmScriptChecks({&ws, 1});
     if (!PolicyScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
 
     if (!ConsensusScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
@@ -1600,6 +1658,7 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         }
     }
 
+    PrewarmScriptChecks(workspaces);
     for (Workspace& ws : workspaces) {
         ws.m_package_feerate = package_feerate;
         if (!PolicyScriptChecks(args, ws)) {
@@ -1876,7 +1935,8 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package& package,
 } // anon namespace
 
 MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTransactionRef& tx,
-                                       int64_t accept_time, bool bypass_limits, bool test_accept)
+                                       int64_t accept_time, bool bypass_limits, bool test_accept,
+                                       bool scripts_prewarmed)
 {
     AssertLockHeld(::cs_main);
     const CChainParams& chainparams{active_chainstate.m_chainman.GetParams()};
@@ -1884,7 +1944,7 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
     CTxMemPool& pool{*active_chainstate.GetMempool()};
 
     std::vector<COutPoint> coins_to_uncache;
-    auto args = MemPoolAccept::ATMPArgs::SingleAccept(chainparams, accept_time, bypass_limits, coins_to_uncache, test_accept);
+    auto args = MemPoolAccept::ATMPArgs::SingleAccept(chainparams, accept_time, bypass_limits, coins_to_uncache, test_accept, scripts_prewarmed);
     MempoolAcceptResult result = MemPoolAccept(pool, active_chainstate).AcceptSingleTransaction(tx, args);
     if (result.m_result_type != MempoolAcceptResult::ResultType::VALID) {
         // Remove coins that were not present in the coins cache before calling
@@ -1905,6 +1965,43 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
     return result;
 }
 
+void PrewarmSignatureCache(Chainstate& active_chainstate, const CTxMemPool& pool, std::span<const CTransactionRef> txs)
+{
+    AssertLockHeld(cs_main);
+    ChainstateManager& chainman{active_chainstate.m_chainman};
+    auto& check_queue{chainman.GetCheckQueue()};
+    if (!check_queue.HasThreads()) return;
+
+    // Spent outputs are looked up like in package validation: in the UTXO
+    // set, in the mempool, and in the transactions of txs added so far.
+    CCoinsViewMemPool view_mempool{&active_chainstate.CoinsTip(), pool};
+    CCoinsViewCache view{&view_mempool};
+    std::vector<PrecomputedTransactionData> txdata(txs.size());
+    std::vector<CScriptCheck> checks;
+    size_t missing_inputs{0};
+    for (size_t i{0}; i < txs.size(); ++i) {
+        const CTransaction& tx{*txs[i]};
+        if (tx.IsCoinBase()) continue;
+        if (view.HaveInputs(tx)) {
+            TxValidationState state_dummy;
+            CheckInputScripts(tx, state_dummy, view, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheSigStore=*/true,
+                              /*cacheFullScriptStore=*/false, txdata[i], chainman.m_validation_cache, &checks);
+        } else {
+            ++missing_inputs;
+        }
+        view_mempool.PackageAddTransaction(txs[i]);
+    }
+    if (missing_inputs > 0) {
+        LogDebug(BCLog::MEMPOOL, "Not prewarming %u of %u transactions with missing inputs\n", missing_inputs, txs.size());
+    }
+
+    CCheckQueueControl<CScriptCheck> control(&check_queue);
+    control.Add(std::move(checks));
+    if (control.Complete()) {
+        LogDebug(BCLog::MEMPOOL, "Script check failed while prewarming %u transactions\n", txs.size());
+    }
+}
+
 PackageMempoolAcceptResult ProcessNewPackage(Chainstate& active_chainstate, CTxMemPool& pool,
                                                    const Package& package, bool test_accept, const std::optional<CFeeRate>& client_maxfeerate)
 {
@@ -2114,6 +2211,9 @@ void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, CTxUndo &txund
 }
 
 std::optional<std::pair<ScriptError, std::string>> CScriptCheck::operator()() {
+    if (m_txdata_init) {
+        std::call_once(m_txdata_init->m_once, [this] { txdata->Init(*ptxTo, std::move(m_txdata_init->m_spent_outputs)); });
+    }
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
     const CScriptWitness *witness = &ptxTo->vin[nIn].scriptWitness;
     ScriptError error{SCRIPT_ERR_UNKNOWN_ERROR};
@@ -2151,6 +2251,9 @@ ValidationCache::ValidationCache(const size_t script_execution_cache_bytes, cons
  * script checks which are not necessary (eg due to script execution cache hits) are, obviously,
  * not pushed onto pvChecks/run.
  *
+ * If pvChecks and txdata_init are not nullptr and txdata is not initialized yet, its initialization
+ * is left to the first of the pushed script checks that runs. txdata_init must then outlive them.
+ *
  * Setting cacheSigStore/cacheFullScriptStore to false will remove elements from the corresponding cache
  * which are matched. This is useful for checking blocks where we will likely never need the cache
  * entry again.
@@ -2164,7 +2267,8 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
                        const CCoinsViewCache& inputs, unsigned int flags, bool cacheSigStore,
                        bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
                        ValidationCache& validation_cache,
-                       std::vector<CScriptCheck>* pvChecks)
+                       std::vector<CScriptCheck>* pvChecks,
+                       DeferredTxDataInit* txdata_init)
 {
     if (tx.IsCoinBase()) return true;
 
@@ -2195,9 +2299,17 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
             assert(!coin.IsSpent());
             spent_outputs.emplace_back(coin.out);
         }
-        txdata.Init(tx, std::move(spent_outputs));
+        if (pvChecks && txdata_init) {
+            txdata_init->m_spent_outputs = std::move(spent_outputs);
+        } else {
+            txdata.Init(tx, std::move(spent_outputs));
+            txdata_init = nullptr;
+        }
+    } else {
+        txdata_init = nullptr;
     }
-    assert(txdata.m_spent_outputs.size() == tx.vin.size());
+    const std::vector<CTxOut>& spent_outputs{txdata_init ? txdata_init->m_spent_outputs : txdata.m_spent_outputs};
+    assert(spent_outputs.size() == tx.vin.size());
 
     for (unsigned int i = 0; i < tx.vin.size(); i++) {
 
@@ -2208,7 +2320,7 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
         // spent being checked as a part of CScriptCheck.
 
         // Verify signature
-        CScriptCheck check(txdata.m_spent_outputs[i], tx, validation_cache.m_signature_cache, i, flags, cacheSigStore, &txdata);
+        CScriptCheck check(spent_outputs[i], tx, validation_cache.m_signature_cache, i, flags, cacheSigStore, &txdata, txdata_init);
         if (pvChecks) {
             pvChecks->emplace_back(std::move(check));
         } else if (auto result = check(); result.has_value()) {
@@ -2634,9 +2746,11 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // until after `control` has run the script checks (potentially
     // in multiple threads). Preallocate the vector size so a new allocation
     // doesn't invalidate pointers into the vector, and keep txsdata in scope
-    // for as long as `control`.
+    // for as long as `control`. The same applies to txsdata_init, which lets
+    // the script check workers initialize txsdata instead of this thread.
     CCheckQueueControl<CScriptCheck> control(fScriptChecks && parallel_script_checks ? &m_chainman.GetCheckQueue() : nullptr);
     std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
+    std::vector<DeferredTxDataInit> txsdata_init(block.vtx.size());
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -2698,7 +2812,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
             TxValidationState tx_state;
-            if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, txsdata[i], m_chainman.m_validation_cache, parallel_script_checks ? &vChecks : nullptr)) {
+            if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, txsdata[i], m_chainman.m_validation_cache, parallel_script_checks ? &vChecks : nullptr, &txsdata_init[i])) {
                 // Any transaction validation failure in ConnectBlock is a block consensus failure
                 state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
                               tx_state.GetRejectReason(), tx_state.GetDebugMessage());
@@ -3196,6 +3310,11 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     LogDebug(BCLog::BENCH, "  - Load block from disk: %.2fms\n",
              Ticks<MillisecondsDouble>(time_2 - time_1));
     {
+        // Read the inputs that are not cached yet from disk in parallel, so
+        // that ConnectBlock can run from memory.
+        m_chainman.GetInputFetcher().FetchInputs(CoinsTip(), CoinsDB(), blockConnecting);
+        LogDebug(BCLog::BENCH, "  - Fetch inputs: %.2fms\n",
+                 Ticks<MillisecondsDouble>(SteadyClock::now() - time_2));
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
         if (m_chainman.m_options.signals) {
@@ -5018,9 +5137,7 @@ bool ChainstateManager::LoadBlockIndex()
 
         m_blockman.ScanAndUnlinkAlreadyPrunedFiles();
 
-        std::vector<CBlockIndex*> vSortedByHeight{m_blockman.GetAllBlockIndices()};
-        std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
-                  CBlockIndexHeightOnlyComparator());
+        std::vector<CBlockIndex*> vSortedByHeight{m_blockman.GetAllBlockIndicesByHeight()};
 
         for (CBlockIndex* pindex : vSortedByHeight) {
             if (m_interrupt) return false;
@@ -5077,14 +5194,8 @@ bool Chainstate::LoadGenesisBlock()
     return true;
 }
 
-void ChainstateManager::LoadExternalBlockFile(
-    AutoFile& file_in,
-    FlatFilePos* dbp,
-    std::multimap<uint256, FlatFilePos>* blocks_with_unknown_parent)
+void ChainstateManager::LoadExternalBlockFile(AutoFile& file_in)
 {
-    // Either both should be specified (-reindex), or neither (-loadblock).
-    assert(!dbp == !blocks_with_unknown_parent);
-
     const auto start{SteadyClock::now()};
     const CChainParams& params{GetParams()};
 
@@ -5122,8 +5233,6 @@ void ChainstateManager::LoadExternalBlockFile(
             try {
                 // read block header
                 const uint64_t nBlockPos{blkdat.GetPos()};
-                if (dbp)
-                    dbp->nPos = nBlockPos;
                 blkdat.SetLimit(nBlockPos + nSize);
                 CBlockHeader header;
                 blkdat >> header;
@@ -5137,13 +5246,10 @@ void ChainstateManager::LoadExternalBlockFile(
 
                 {
                     LOCK(cs_main);
-                    // detect out of order blocks, and store them for later
+                    // detect out of order blocks, and skip them
                     if (hash != params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(header.hashPrevBlock)) {
                         LogDebug(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
                                  header.hashPrevBlock.ToString());
-                        if (dbp && blocks_with_unknown_parent) {
-                            blocks_with_unknown_parent->emplace(header.hashPrevBlock, *dbp);
-                        }
                         continue;
                     }
 
@@ -5157,7 +5263,7 @@ void ChainstateManager::LoadExternalBlockFile(
                         nRewind = blkdat.GetPos();
 
                         BlockValidationState state;
-                        if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr, true)) {
+                        if (AcceptBlock(pblock, state, nullptr, true, nullptr, nullptr, true)) {
                             nLoaded++;
                         }
                         if (state.IsError()) {
@@ -5205,34 +5311,6 @@ void ChainstateManager::LoadExternalBlockFile(
                 }
 
                 NotifyHeaderTip();
-
-                if (!blocks_with_unknown_parent) continue;
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    auto range = blocks_with_unknown_parent->equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, FlatFilePos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (m_blockman.ReadBlock(*pblockrecursive, it->second)) {
-                            LogDebug(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            BlockValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr, true)) {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        blocks_with_unknown_parent->erase(it);
-                        NotifyHeaderTip();
-                    }
-                }
             } catch (const std::exception& e) {
                 // historical bugs added extra data to the block files that does not deserialize cleanly.
                 // commonly this data is between readable blocks, but it does not really matter. such data is not fatal to the import process.
@@ -5254,6 +5332,87 @@ void ChainstateManager::LoadExternalBlockFile(
     LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
 }
 
+void ChainstateManager::LoadReindexBlocks(std::span<const node::ReindexBlock> blocks, node::BlockReorderBuffer& blocks_with_unknown_parent)
+{
+    const auto start{SteadyClock::now()};
+    const CChainParams& params{GetParams()};
+
+    int nLoaded = 0;
+    for (const auto& [pblock, pos] : blocks) {
+        if (m_interrupt) return;
+
+        const uint256 hash{pblock->GetHash()};
+        {
+            LOCK(cs_main);
+            // detect out of order blocks, and store them for later
+            if (hash != params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(pblock->hashPrevBlock)) {
+                LogDebug(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                         pblock->hashPrevBlock.ToString());
+                blocks_with_unknown_parent.Add({pblock, pos});
+                continue;
+            }
+
+            // process in case the block isn't known yet
+            const CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
+            if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
+                BlockValidationState state;
+                if (AcceptBlock(pblock, state, nullptr, true, &pos, nullptr, true)) {
+                    nLoaded++;
+                }
+                if (state.IsError()) {
+                    break;
+                }
+            } else if (hash != params.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
+                LogDebug(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
+            }
+        }
+
+        // Activate the genesis block so normal node progress can continue
+        // During first -reindex, this will only connect Genesis since
+        // ActivateBestChain only connects blocks which are in the block tree db,
+        // which only contains blocks whose parents are in it.
+        // But do this only if genesis isn't activated yet, to avoid connecting many blocks
+        // without assumevalid in the case of a continuation of a reindex that
+        // was interrupted by the user.
+        if (hash == params.GetConsensus().hashGenesisBlock && WITH_LOCK(::cs_main, return ActiveHeight()) == -1) {
+            BlockValidationState state;
+            if (!ActiveChainstate().ActivateBestChain(state, nullptr)) {
+                break;
+            }
+        }
+
+        NotifyHeaderTip();
+
+        // Recursively process earlier encountered successors of this block
+        std::deque<uint256> queue;
+        queue.push_back(hash);
+        while (!queue.empty()) {
+            const uint256 head{queue.front()};
+            queue.pop_front();
+            for (auto& [child, child_pos] : blocks_with_unknown_parent.Take(head)) {
+                if (!child) {
+                    // The block did not fit in the reorder buffer; read it again.
+                    auto pblockrecursive{std::make_shared<CBlock>()};
+                    if (!m_blockman.ReadBlock(*pblockrecursive, child_pos)) continue;
+                    child = std::move(pblockrecursive);
+                }
+                LogDebug(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, child->GetHash().ToString(),
+                         head.ToString());
+                {
+                    LOCK(cs_main);
+                    BlockValidationState dummy;
+                    if (AcceptBlock(child, dummy, nullptr, true, &child_pos, nullptr, true)) {
+                        nLoaded++;
+                        queue.push_back(child->GetHash());
+                    }
+                }
+                NotifyHeaderTip();
+            }
+        }
+    }
+    LogPrintf("Loaded %i blocks from block file in %dms\n", nLoaded, Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+}
+
 bool ChainstateManager::ShouldCheckBlockIndex() const
 {
     // Assert to verify Flatten() has been called.
@@ -6308,6 +6467,7 @@ static ChainstateManager::Options&& Flatten(ChainstateManager::Options&& opts)
 
 ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Options options, node::BlockManager::Options blockman_options)
     : m_script_check_queue{/*batch_size=*/128, std::clamp(options.worker_threads_num, 0, MAX_SCRIPTCHECK_THREADS)},
+      m_input_fetcher{/*batch_size=*/16, std::clamp(options.input_fetch_threads_num, 0, MAX_INPUT_FETCH_THREADS)},
       m_interrupt{interrupt},
       m_options{Flatten(std::move(options))},
       m_blockman{interrupt, std::move(blockman_options)},
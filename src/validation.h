@@ -13,6 +13,7 @@
 #include <consensus/amount.h>
 #include <cuckoocache.h>
 #include <deploymentstatus.h>
+#include <inputfetcher.h>
 #include <kernel/chain.h>
 #include <kernel/chainparams.h>
 #include <kernel/chainstatemanager_opts.h>
@@ -37,6 +38,7 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
 #include <span>
@@ -80,6 +82,8 @@ static const uint64_t MIN_DISK_SPACE_FOR_BLOCK_FILES = 550 * 1024 * 1024;
 
 /** Maximum number of dedicated script-checking threads allowed */
 static constexpr int MAX_SCRIPTCHECK_THREADS{15};
+/** Maximum number of threads reading block inputs ahead of ConnectBlock */
+static constexpr int MAX_INPUT_FETCH_THREADS{16};
 
 /** Current sync state passed to tip changed callbacks. */
 enum class SynchronizationState {
@@ -260,11 +264,29 @@ struct PackageMempoolAcceptResult
  * @param[in]  bypass_limits      When true, don't enforce mempool fee and capacity limits,
  *                                and set entry_sequence to zero.
  * @param[in]  test_accept        When true, run validation checks but don't submit to mempool.
+ * @param[in]  scripts_prewarmed  When true, the caller already ran PrewarmSignatureCache for tx,
+ *                                so its inputs are not spread over the script check threads again.
  *
  * @returns a MempoolAcceptResult indicating whether the transaction was accepted/rejected with reason.
  */
 MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTransactionRef& tx,
-                                       int64_t accept_time, bool bypass_limits, bool test_accept)
+                                       int64_t accept_time, bool bypass_limits, bool test_accept,
+                                       bool scripts_prewarmed = false)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/**
+ * Verify the input scripts of txs with the standard script verification flags
+ * on the script check worker threads, so that their signatures end up in the
+ * signature cache. Subsequent AcceptToMemoryPool calls for them then mostly
+ * hit the cache instead of verifying every signature on the calling thread.
+ *
+ * Inputs are checked through CheckInputScripts on a view of the UTXO set,
+ * pool and the outputs of txs itself (parents must come before their
+ * children). Transactions with inputs that can't be found are skipped and
+ * logged. The result is otherwise ignored: a failing check stops the
+ * remaining ones, which only means those are verified serially later.
+ */
+void PrewarmSignatureCache(Chainstate& active_chainstate, const CTxMemPool& pool, std::span<const CTransactionRef> txs)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 /**
@@ -323,6 +345,19 @@ std::optional<LockPoints> CalculateLockPointsAtTip(
 bool CheckSequenceLocksAtTip(CBlockIndex* tip,
                              const LockPoints& lock_points);
 
+/**
+ * The spent outputs of a transaction whose PrecomputedTransactionData has not
+ * been initialized yet. Passing this to CheckInputScripts together with
+ * pvChecks defers the initialization, which hashes the whole transaction, to
+ * whichever of the transaction's script checks runs first. This moves the
+ * work from the thread queueing the checks to the script check workers.
+ */
+struct DeferredTxDataInit
+{
+    std::once_flag m_once;
+    std::vector<CTxOut> m_spent_outputs;
+};
+
 /**
  * Closure representing one script verification
  * Note that this stores references to the spending transaction
@@ -337,10 +372,12 @@ private:
     bool cacheStore;
     PrecomputedTransactionData *txdata;
     SignatureCache* m_signature_cache;
+    //! If not nullptr, txdata is initialized from this before the script is verified.
+    DeferredTxDataInit* m_txdata_init;
 
 public:
-    CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, SignatureCache& signature_cache, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn) :
-        m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), txdata(txdataIn), m_signature_cache(&signature_cache) { }
+    CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, SignatureCache& signature_cache, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn, DeferredTxDataInit* txdata_init = nullptr) :
+        m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), txdata(txdataIn), m_signature_cache(&signature_cache), m_txdata_init(txdata_init) { }
 
     CScriptCheck(const CScriptCheck&) = delete;
     CScriptCheck& operator=(const CScriptCheck&) = delete;
@@ -949,6 +986,9 @@ private:
     //! A queue for script verifications that have to be performed by worker threads.
     CCheckQueue<CScriptCheck> m_script_check_queue;
 
+    //! Worker threads that load the inputs of a block into the coins cache before it is connected.
+    InputFetcher m_input_fetcher;
+
     //! Timers and counters used for benchmarking validation in both background
     //! and active chainstates.
     SteadyClock::duration GUARDED_BY(::cs_main) time_check{};
@@ -1154,33 +1194,26 @@ public:
     /**
      * Import blocks from an external file
      *
-     * During reindexing, this function is called for each block file (datadir/blocks/blk?????.dat).
-     * It reads all blocks contained in the given file and attempts to process them (add them to the
-     * block index). The blocks may be out of order within each file and across files. Often this
-     * function reads a block but finds that its parent hasn't been read yet, so the block can't be
-     * processed yet. The function will add an entry to the blocks_with_unknown_parent map (which is
-     * passed as an argument), so that when the block's parent is later read and processed, this
-     * function can re-read the child block from disk and process it.
-     *
-     * Because a block's parent may be in a later file, not just later in the same file, the
-     * blocks_with_unknown_parent map must be passed in and out with each call. It's a multimap,
-     * rather than just a map, because multiple blocks may have the same parent (when chain splits
-     * or stale blocks exist). It maps from parent-hash to child-disk-position.
-     *
-     * This function can also be used to read blocks from user-specified block files using the
-     * -loadblock= option. There's no unknown-parent tracking, so the last two arguments are omitted.
-     *
+     * This function is used to read blocks from user-specified block files using the -loadblock=
+     * option. It reads all blocks contained in the given file and attempts to process them (add
+     * them to the block index). Blocks whose parent hasn't been read yet are skipped.
      *
      * @param[in]     file_in                       File containing blocks to read
-     * @param[in]     dbp                           (optional) Disk block position (only for reindex)
-     * @param[in,out] blocks_with_unknown_parent    (optional) Map of disk positions for blocks with
-     *                                              unknown parent, key is parent block hash
-     *                                              (only used for reindex)
      * */
-    void LoadExternalBlockFile(
-        AutoFile& file_in,
-        FlatFilePos* dbp = nullptr,
-        std::multimap<uint256, FlatFilePos>* blocks_with_unknown_parent = nullptr);
+    void LoadExternalBlockFile(AutoFile& file_in);
+
+    /**
+     * Add the blocks read from a block file during reindexing (see node::ReadBlockFile()) to the
+     * block index, in the order they were read. The blocks may be out of order within each file
+     * and across files. Often a block's parent hasn't been read yet, so the block can't be
+     * processed yet. It is then added to blocks_with_unknown_parent, and processed when its
+     * parent is. Because a block's parent may be in a later file, blocks_with_unknown_parent must
+     * be passed in and out with each call.
+     *
+     * @param[in]     blocks                        Blocks read from one block file, with their positions
+     * @param[in,out] blocks_with_unknown_parent    Blocks with unknown parent, by parent block hash
+     */
+    void LoadReindexBlocks(std::span<const node::ReindexBlock> blocks, node::BlockReorderBuffer& blocks_with_unknown_parent);
 
     /**
      * Process an incoming block. This only returns after the best known valid
@@ -1323,6 +1356,7 @@ public:
     void RecalculateBestHeader() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
+    InputFetcher& GetInputFetcher() { return m_input_fetcher; }
 
     ~ChainstateManager();
 };
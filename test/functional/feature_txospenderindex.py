@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# Copyright (c) The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the spent output index (-txospenderindex).
+
+Test that gettxspendingprevout reports confirmed spends and the block
+containing them on a node running the index, also across a reorg, and
+only mempool spends on a node without it.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+
+class TxoSpenderIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-txospenderindex"],
+            [],
+        ]
+
+    def run_test(self):
+        index_node, plain_node = self.nodes
+        wallet = MiniWallet(index_node)
+
+        self.log.info("Check that the index is listed in getindexinfo")
+        self.wait_until(lambda: index_node.getindexinfo("txospenderindex")["txospenderindex"]["synced"])
+        assert_equal(plain_node.getindexinfo(), {})
+
+        utxo = wallet.get_utxo()
+        prevout = {"txid": utxo["txid"], "vout": utxo["vout"]}
+        tx = wallet.send_self_transfer(from_node=index_node, utxo_to_spend=utxo)
+        self.sync_mempools()
+
+        self.log.info("Check that mempool spends are reported without a block hash")
+        for node in self.nodes:
+            assert_equal(node.gettxspendingprevout([prevout]), [{**prevout, "spendingtxid": tx["txid"]}])
+
+        self.log.info("Check that confirmed spends are only reported by the node running the index")
+        block_hash = self.generate(index_node, 1)[0]
+        assert_equal(index_node.gettxspendingprevout([prevout]), [{**prevout, "spendingtxid": tx["txid"], "blockhash": block_hash}])
+        assert_equal(plain_node.gettxspendingprevout([prevout]), [prevout])
+
+        self.log.info("Check that spends in reorged out blocks are removed from the index")
+        index_node.invalidateblock(block_hash)
+        assert tx["txid"] in index_node.getrawmempool()
+        assert_equal(index_node.gettxspendingprevout([prevout]), [{**prevout, "spendingtxid": tx["txid"]}])
+
+        self.log.info("Check that the block hash follows the spend into the new chain")
+        # Mine to another address, so the first block does not repeat the invalidated one
+        new_block_hash = self.generatetoaddress(index_node, 2, wallet.get_address())[0]
+        assert new_block_hash != block_hash
+        assert_equal(index_node.gettxspendingprevout([prevout]), [{**prevout, "spendingtxid": tx["txid"], "blockhash": new_block_hash}])
+        assert_equal(plain_node.gettxspendingprevout([prevout]), [prevout])
+
+
+if __name__ == '__main__':
+    TxoSpenderIndexTest(__file__).main()
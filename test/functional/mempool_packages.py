@@ -148,6 +148,14 @@ class MempoolPackagesTest(BitcoinTestFramework):
             assert_equal(mempool[x], v_descendants[x])
         assert chain[0] not in v_descendants.keys()
 
+        # The verbose results list the same transactions in the same order as
+        # the non-verbose ones, with the same data as getmempoolentry.
+        for verbose_result, txids in ((v_ancestors, self.nodes[0].getmempoolancestors(chain[-1])),
+                                      (v_descendants, self.nodes[0].getmempooldescendants(chain[0]))):
+            assert_equal(list(verbose_result.keys()), txids)
+            for txid, entry in verbose_result.items():
+                assert_equal(entry, self.nodes[0].getmempoolentry(txid))
+
         # Check that ancestor modified fees includes fee deltas from
         # prioritisetransaction
         self.nodes[0].prioritisetransaction(txid=chain[0], fee_delta=1000)
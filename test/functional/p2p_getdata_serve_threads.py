@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+# Copyright (c) The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test serving block requests from message serving threads (-msgservethreads).
+
+Check that every peer gets the blocks it requested, in order and before the
+replies to its later messages, and that a node can sync from a peer that
+serves blocks from those threads.
+"""
+
+from test_framework.messages import (
+    CInv,
+    MSG_BLOCK,
+    MSG_WITNESS_FLAG,
+    msg_getdata,
+    msg_ping,
+)
+from test_framework.p2p import P2PInterface
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+# Nonce of the ping sent after the getdata, distinct from the ones the test
+# framework uses to sync with the node
+PING_NONCE = 0xffff
+
+
+class P2PRecordReplies(P2PInterface):
+    def __init__(self):
+        super().__init__()
+        self.replies = []
+
+    def on_block(self, message):
+        message.block.calc_sha256()
+        self.replies.append(message.block.sha256)
+
+    def on_pong(self, message):
+        if message.nonce == PING_NONCE:
+            self.replies.append("pong")
+
+
+class GetdataServeThreadsTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [["-msgservethreads=2"], []]
+
+    def setup_network(self):
+        self.setup_nodes()
+
+    def run_test(self):
+        node = self.nodes[0]
+        block_hashes = [int(node.getblockhash(height), 16) for height in range(1, 21)]
+
+        self.log.info("Check that blocks requested by several peers are served in order")
+        peers = [node.add_p2p_connection(P2PRecordReplies()) for _ in range(4)]
+        for peer in peers:
+            peer.send_message(msg_getdata([CInv(MSG_BLOCK | MSG_WITNESS_FLAG, block_hash) for block_hash in block_hashes]))
+            peer.send_message(msg_ping(nonce=PING_NONCE))
+        for peer in peers:
+            peer.wait_until(lambda: len(peer.replies) == len(block_hashes) + 1)
+            assert_equal(peer.replies, block_hashes + ["pong"])
+
+        self.log.info("Check that a node syncs from a peer serving blocks from the serving threads")
+        self.generate(node, 50, sync_fun=self.no_op)
+        self.connect_nodes(1, 0)
+        self.sync_blocks()
+
+
+if __name__ == '__main__':
+    GetdataServeThreadsTest(__file__).main()
@@ -100,6 +100,31 @@ class RpcMiscTest(BitcoinTestFramework):
         # Specifying an unknown index name returns an empty result
         assert_equal(node.getindexinfo("foo"), {})
 
+        self.log.info("test getmemoryinfo blockservecache")
+        # The block serve cache is disabled by default
+        self.restart_node(0)
+        blockhash = node.getbestblockhash()
+        node.getblock(blockhash)
+        assert_equal(node.getmemoryinfo()['blockservecache'], {'entries': 0, 'usage': 0, 'hits': 0, 'misses': 0})
+
+        self.restart_node(0, ["-blockservecache=1"])
+        node.getblock(blockhash)
+        cache = node.getmemoryinfo()['blockservecache']
+        assert_equal(cache['entries'], 1)
+        assert_equal(cache['hits'], 0)
+        assert_greater_than(cache['misses'], 0)
+        assert_greater_than(cache['usage'], 0)
+        # The second request for the same block is served from memory
+        node.getblock(blockhash)
+        cache_after = node.getmemoryinfo()['blockservecache']
+        assert_equal(cache_after['entries'], 1)
+        assert_equal(cache_after['hits'], cache['hits'] + 1)
+        assert_equal(cache_after['misses'], cache['misses'])
+
+        self.stop_node(0)
+        node.assert_start_raises_init_error(["-blockservecache=-1"], "Error: -blockservecache cannot be configured with a negative value.")
+        self.start_node(0)
+
 
 if __name__ == '__main__':
     RpcMiscTest(__file__).main()